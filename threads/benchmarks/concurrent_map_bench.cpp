@@ -0,0 +1,89 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// Scaling benchmark for concurrent_unordered_map.
+// Each pass runs a mixed insert/find/update load on a ThreadPool of 1, 2, 4 ... getNumCores() threads
+// and reports throughput relative to the single thread pass.
+
+#include <chrono>
+#include <iostream>
+#include <MultiCoreUtil.h>
+#include <concurrent_unordered_map.h>
+
+using namespace std;
+using namespace MultiCore;
+
+namespace
+{
+
+double runPass(size_t numThreads, size_t numOps)
+{
+	ThreadPool pool(numThreads, numThreads, numThreads);
+	concurrent_unordered_map<size_t, size_t> registry;
+
+	const size_t keyRange = numOps / 4;
+	auto start = chrono::steady_clock::now();
+	pool.run(numOps, [&registry, keyRange](size_t threadNum, size_t idx)->bool {
+		size_t key = (idx * 2654435761ull) % keyRange;
+		switch (idx % 4) {
+			case 0:
+				registry.insert(key, idx);
+				break;
+			case 1:
+				registry.update(key, [](size_t& val) { val++; });
+				break;
+			default: {
+				size_t val;
+				registry.find(key, val);
+				break;
+			}
+		}
+		return true;
+	}, numThreads > 1);
+	auto end = chrono::steady_clock::now();
+
+	return chrono::duration<double>(end - start).count();
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const size_t numOps = 4 * 1000 * 1000;
+	size_t maxThreads = getNumCores();
+
+	double baseTime = 0;
+	cout << "threads, seconds, Mops/s, speedup\n";
+	for (size_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+		double t = runPass(numThreads, numOps);
+		if (numThreads == 1)
+			baseTime = t;
+		cout << numThreads << ", " << t << ", " << (numOps / t) * 1.0e-6 << ", " << baseTime / t << "\n";
+	}
+
+	return 0;
+}
@@ -0,0 +1,339 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// Differential test and benchmark for the pool containers against their std counterparts.
+//
+// For each container, size and thread count every worker builds its own container from its own random keys, the way
+// DFHM blocks each own their data. MultiCore containers run with a local_heap per worker. Phases are insert, find,
+// iterate, copy and erase, each timed as a separate ThreadPool::run.
+//
+// Every phase returns a checksum per worker (hit counts, order sensitive hash of the contents, sizes). The MultiCore
+// and std checksums must match exactly, any difference is reported as a failure and the exit code is non zero.
+//
+// Allocation counts and peak bytes come from the global operator new below. local_heap gets its blocks from the
+// global heap, so both implementations are measured the same way.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <random>
+#include <set>
+#include <vector>
+#include <MultiCoreUtil.h>
+#include <local_heap.h>
+#include <pool_vector.h>
+#include <pool_set.h>
+#include <pool_map.h>
+
+using namespace std;
+
+namespace
+{
+
+atomic<size_t> s_numAllocs = 0;
+atomic<size_t> s_curBytes = 0;
+atomic<size_t> s_peakBytes = 0;
+
+// Size prefix so delete knows how many bytes are released. 16 keeps the default new alignment.
+const size_t ALLOC_HEADER = 16;
+
+void* countedAlloc(size_t numBytes)
+{
+	char* p = (char*)malloc(numBytes + ALLOC_HEADER);
+	if (!p)
+		throw bad_alloc();
+	*(size_t*)p = numBytes;
+
+	s_numAllocs.fetch_add(1, memory_order_relaxed);
+	size_t cur = s_curBytes.fetch_add(numBytes, memory_order_relaxed) + numBytes;
+	size_t peak = s_peakBytes.load(memory_order_relaxed);
+	while (cur > peak && !s_peakBytes.compare_exchange_weak(peak, cur, memory_order_relaxed))
+		;
+	return p + ALLOC_HEADER;
+}
+
+void countedFree(void* ptr)
+{
+	if (!ptr)
+		return;
+	char* p = (char*)ptr - ALLOC_HEADER;
+	s_curBytes.fetch_sub(*(size_t*)p, memory_order_relaxed);
+	free(p);
+}
+
+}
+
+void* operator new(size_t numBytes) { return countedAlloc(numBytes); }
+void* operator new[](size_t numBytes) { return countedAlloc(numBytes); }
+void operator delete(void* ptr) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { countedFree(ptr); }
+
+namespace
+{
+
+enum Phase {
+	PH_INSERT,
+	PH_FIND,
+	PH_ITERATE,
+	PH_COPY,
+	PH_ERASE,
+	PH_COUNT,
+};
+
+const char* s_phaseNames[PH_COUNT] = { "insert", "find", "iterate", "copy", "erase" };
+
+inline uint64_t mixHash(uint64_t hash, uint64_t val)
+{
+	return (hash ^ val) * 0x100000001B3ull;
+}
+
+// Adapters give the vector, set and map containers one interface. Both implementations use the same adapter code
+// so a checksum difference can only come from the containers.
+
+template<class VEC>
+struct VectorOps {
+	static uint64_t insert(VEC& c, const vector<size_t>& keys) {
+		for (size_t key : keys)
+			c.push_back(key);
+		return c.size();
+	}
+	static uint64_t find(VEC& c, const vector<size_t>& keys) {
+		uint64_t hash = 0;
+		for (size_t key : keys)
+			hash = mixHash(hash, c[key % c.size()]);
+		return hash;
+	}
+	static uint64_t erase(VEC& c, const vector<size_t>& keys) {
+		for (size_t i = 0; i < keys.size() / 2 && !c.empty(); i++)
+			c.pop_back();
+		return c.size();
+	}
+};
+
+template<class SET>
+struct SetOps {
+	static uint64_t insert(SET& c, const vector<size_t>& keys) {
+		for (size_t key : keys)
+			c.insert(key);
+		return c.size();
+	}
+	static uint64_t find(SET& c, const vector<size_t>& keys) {
+		uint64_t hits = 0;
+		for (size_t key : keys)
+			hits += c.count(key) + c.count(key + 1);
+		return hits;
+	}
+	static uint64_t erase(SET& c, const vector<size_t>& keys) {
+		for (size_t i = 0; i < keys.size(); i += 2)
+			c.erase(keys[i]);
+		return c.size();
+	}
+};
+
+template<class MAP>
+struct MapOps {
+	static uint64_t insert(MAP& c, const vector<size_t>& keys) {
+		for (size_t i = 0; i < keys.size(); i++)
+			c[keys[i]] = i;
+		return c.size();
+	}
+	static uint64_t find(MAP& c, const vector<size_t>& keys) {
+		uint64_t hash = 0;
+		for (size_t key : keys) {
+			auto iter = c.find(key + (key & 1));
+			if (iter != c.end())
+				hash = mixHash(hash, iter->second);
+		}
+		return hash;
+	}
+	static uint64_t erase(MAP& c, const vector<size_t>& keys) {
+		for (size_t i = 0; i < keys.size(); i += 2) {
+			auto iter = c.find(keys[i]);
+			if (iter != c.end())
+				c.erase(iter);
+		}
+		return c.size();
+	}
+};
+
+template<class C>
+uint64_t iterateHash(const C& c)
+{
+	uint64_t hash = 0;
+	for (const auto& entry : c) {
+		if constexpr (is_integral_v<remove_cvref_t<decltype(entry)>>)
+			hash = mixHash(hash, entry);
+		else
+			hash = mixHash(mixHash(hash, entry.first), entry.second);
+	}
+	return hash;
+}
+
+struct PhaseResult {
+	double _seconds = 0;
+	size_t _numAllocs = 0;
+	vector<uint64_t> _checksums;
+};
+
+struct PassResult {
+	PhaseResult _phases[PH_COUNT];
+	size_t _peakBytes = 0;
+};
+
+template<class C, class OPS, bool USE_LOCAL_HEAP>
+PassResult runPass(const MultiCore::ThreadPool& pool, size_t numThreads, size_t numKeys, uint64_t seed)
+{
+	struct Worker {
+		Worker() : _heap(1024) {}
+		MultiCore::local_heap _heap; // Must be destroyed after _container
+		unique_ptr<C> _container;
+		vector<size_t> _keys;
+	};
+
+	vector<unique_ptr<Worker>> workers(numThreads);
+	for (size_t i = 0; i < numThreads; i++) {
+		workers[i] = make_unique<Worker>();
+		mt19937_64 rng(seed + i);
+		auto& keys = workers[i]->_keys;
+		keys.resize(numKeys);
+		for (auto& key : keys)
+			key = rng() % (4 * numKeys);
+	}
+
+	PassResult result;
+	size_t baseBytes = s_curBytes.load();
+	s_peakBytes = baseBytes;
+
+	for (int phase = 0; phase < PH_COUNT; phase++) {
+		PhaseResult& phaseResult = result._phases[phase];
+		phaseResult._checksums.resize(numThreads);
+		size_t allocsBefore = s_numAllocs.load();
+		auto start = chrono::steady_clock::now();
+
+		pool.run(numThreads, [&workers, &phaseResult, phase](size_t threadNum, size_t idx)->bool {
+			Worker& w = *workers[idx];
+			MultiCore::scoped_set_local_heap heapScope(USE_LOCAL_HEAP ? &w._heap : MultiCore::local_heap::getThreadHeapPtr());
+			uint64_t checksum = 0;
+			switch (phase) {
+				case PH_INSERT:
+					w._container = make_unique<C>();
+					checksum = OPS::insert(*w._container, w._keys);
+					break;
+				case PH_FIND:
+					checksum = OPS::find(*w._container, w._keys);
+					break;
+				case PH_ITERATE:
+					checksum = iterateHash(*w._container);
+					break;
+				case PH_COPY: {
+					C copy(*w._container);
+					checksum = mixHash(iterateHash(copy), copy.size());
+					break;
+				}
+				case PH_ERASE:
+					checksum = mixHash(OPS::erase(*w._container, w._keys), iterateHash(*w._container));
+					w._container.reset();
+					break;
+			}
+			phaseResult._checksums[idx] = checksum;
+			return true;
+		}, numThreads > 1);
+
+		auto end = chrono::steady_clock::now();
+		phaseResult._seconds = chrono::duration<double>(end - start).count();
+		phaseResult._numAllocs = s_numAllocs.load() - allocsBefore;
+	}
+	result._peakBytes = s_peakBytes.load() - baseBytes;
+
+	return result;
+}
+
+void report(const char* pContainer, const char* pImpl, size_t numKeys, size_t numThreads, const PassResult& pass)
+{
+	for (int phase = 0; phase < PH_COUNT; phase++) {
+		const PhaseResult& ph = pass._phases[phase];
+		double mops = (numKeys * numThreads) / ph._seconds * 1.0e-6;
+		cout << pContainer << ", " << pImpl << ", " << numKeys << ", " << numThreads << ", " << s_phaseNames[phase] << ", "
+			<< mops << ", " << ph._numAllocs << ", " << pass._peakBytes / 1024 << "\n";
+	}
+}
+
+template<class POOL_C, class POOL_OPS, class STD_C, class STD_OPS>
+size_t compare(const char* pContainer, const MultiCore::ThreadPool& pool, size_t numKeys, size_t numThreads, uint64_t seed)
+{
+	PassResult poolPass = runPass<POOL_C, POOL_OPS, true>(pool, numThreads, numKeys, seed);
+	PassResult stdPass = runPass<STD_C, STD_OPS, false>(pool, numThreads, numKeys, seed);
+
+	report(pContainer, "MultiCore", numKeys, numThreads, poolPass);
+	report(pContainer, "std", numKeys, numThreads, stdPass);
+
+	size_t numFailures = 0;
+	for (int phase = 0; phase < PH_COUNT; phase++) {
+		if (poolPass._phases[phase]._checksums != stdPass._phases[phase]._checksums) {
+			cerr << "MISMATCH " << pContainer << " size " << numKeys << " threads " << numThreads << " phase " << s_phaseNames[phase] << "\n";
+			numFailures++;
+		}
+	}
+	return numFailures;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const size_t sizes[] = { 1000, 10000, 100000 };
+	const size_t maxThreads = MultiCore::getNumCores();
+	uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 10) : 12345;
+
+	using PoolVec = MultiCore::vector<size_t>;
+	using PoolSet = MultiCore::set<size_t>;
+	using PoolMap = MultiCore::map<size_t, size_t>;
+
+	size_t numFailures = 0;
+	cout << "container, impl, size, threads, phase, Mops/s, allocs, peak KB\n";
+	for (size_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+		MultiCore::ThreadPool pool(numThreads, numThreads, numThreads);
+		for (size_t numKeys : sizes) {
+			numFailures += compare<PoolVec, VectorOps<PoolVec>, vector<size_t>, VectorOps<vector<size_t>>>("vector", pool, numKeys, numThreads, seed);
+			numFailures += compare<PoolSet, SetOps<PoolSet>, set<size_t>, SetOps<set<size_t>>>("set", pool, numKeys, numThreads, seed);
+			numFailures += compare<PoolMap, MapOps<PoolMap>, map<size_t, size_t>, MapOps<map<size_t, size_t>>>("map", pool, numKeys, numThreads, seed);
+		}
+	}
+
+	if (numFailures > 0) {
+		cerr << numFailures << " differential check failures\n";
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,123 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// Throughput of runLambda over an index pool.
+// Compares popping one index at a time under a mutex, which is what runLambda(fLambda, indexPool) did before, with
+// the atomic cursor at batch sizes 1 and 16. The work per index is trivial so the time is the cost of handing out
+// indices. Runs on the global pool at 8, 32 and 64 threads, or the thread counts given on the command line.
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include <MultiCoreUtil.h>
+
+using namespace std;
+using namespace MultiCore;
+
+namespace
+{
+
+template<class L>
+void mutexIndexPool(L fLambda, vector<size_t>& indexPool)
+{
+	mutex indexPoolMutex;
+
+	auto& pool = getGlobalPool();
+	size_t numThreads = pool.getNumThreads();
+	pool.run(numThreads, numThreads, [&fLambda, &indexPool, &indexPoolMutex](size_t threadNum, size_t i)->bool {
+		while (true) {
+			size_t index;
+			{
+				lock_guard<mutex> lock(indexPoolMutex);
+				if (indexPool.empty())
+					break;
+				index = indexPool.back();
+				indexPool.pop_back();
+			}
+
+			if (index != -1)
+				if (!fLambda(index))
+					break;
+		}
+		return true;
+	}, true);
+}
+
+template<class F>
+double nanosPerIndex(size_t numCalls, size_t numIndices, F f)
+{
+	vector<size_t> indexPool(numIndices);
+	double total = 0;
+	for (size_t i = 0; i < numCalls; i++) {
+		for (size_t j = 0; j < numIndices; j++)
+			indexPool[j] = j;
+		indexPool.resize(numIndices);
+
+		auto start = chrono::steady_clock::now();
+		f(indexPool);
+		total += chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+	}
+
+	return total / (numCalls * numIndices);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const size_t numCalls = 50;
+	const size_t numIndices = 50000;
+	vector<size_t> threadCounts = { 8, 32, 64 };
+	if (argc > 1) {
+		threadCounts.clear();
+		for (int i = 1; i < argc; i++)
+			threadCounts.push_back((size_t)atoi(argv[i]));
+	}
+
+	atomic<size_t> sum = 0;
+	auto work = [&sum](size_t index)->bool {
+		sum.fetch_add(index, memory_order_relaxed);
+		return true;
+	};
+
+	cout << "threads, mutex ns/index, cursor ns/index, cursor batch 16 ns/index\n";
+	for (size_t numThreads : threadCounts) {
+		configureGlobalPool(numThreads);
+
+		double locked = nanosPerIndex(numCalls, numIndices, [&](vector<size_t>& indexPool) { mutexIndexPool(work, indexPool); });
+		double cursor = nanosPerIndex(numCalls, numIndices, [&](vector<size_t>& indexPool) { runLambda(work, indexPool, true); });
+		double batched = nanosPerIndex(numCalls, numIndices, [&](vector<size_t>& indexPool) { runLambda(work, indexPool, true, 16); });
+
+		cout << numThreads << ", " << locked << ", " << cursor << ", " << batched << "\n";
+	}
+
+	shutdown();
+	return 0;
+}
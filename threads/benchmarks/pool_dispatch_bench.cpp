@@ -0,0 +1,93 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// Dispatch latency of ThreadPool::run.
+// Each call runs one trivial step per thread, so the time is waking the workers and waiting for them to finish.
+// Reports mean, median and 99th percentile per call at 8, 32 and 64 threads, or the thread counts given on the
+// command line.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <MultiCoreUtil.h>
+
+using namespace std;
+using namespace MultiCore;
+
+namespace
+{
+
+void runPass(size_t numThreads, size_t numCalls)
+{
+	ThreadPool pool(numThreads, numThreads, numThreads);
+	atomic<size_t> sum = 0;
+	auto f = [&sum](size_t threadNum, size_t idx)->bool {
+		sum.fetch_add(idx, memory_order_relaxed);
+		return true;
+	};
+
+	// Warm up, the first call pays for thread start up
+	for (size_t i = 0; i < 10; i++)
+		pool.run(numThreads, f, true);
+
+	vector<double> times(numCalls);
+	for (size_t i = 0; i < numCalls; i++) {
+		auto start = chrono::steady_clock::now();
+		pool.run(numThreads, f, true);
+		times[i] = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+	}
+
+	double mean = 0;
+	for (double t : times)
+		mean += t;
+	mean /= numCalls;
+
+	sort(times.begin(), times.end());
+	cout << numThreads << ", " << mean << ", " << times[numCalls / 2] << ", " << times[(numCalls * 99) / 100] << "\n";
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const size_t numCalls = 2000;
+	vector<size_t> threadCounts = { 8, 32, 64 };
+	if (argc > 1) {
+		threadCounts.clear();
+		for (int i = 1; i < argc; i++)
+			threadCounts.push_back((size_t)atoi(argv[i]));
+	}
+
+	cout << "threads, mean us, median us, p99 us\n";
+	for (size_t numThreads : threadCounts)
+		runPass(numThreads, numCalls);
+
+	return 0;
+}
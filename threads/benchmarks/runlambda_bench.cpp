@@ -0,0 +1,100 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// Per call overhead of runLambda.
+// Compares launching and joining getNumCores() threads per call, which is what runLambda did before it moved onto
+// the global ThreadPool, with the pooled runLambda. The work per call is trivial so the time is dispatch overhead.
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <MultiCoreUtil.h>
+
+using namespace std;
+using namespace MultiCore;
+
+namespace
+{
+
+template<class L>
+void spawnLambda(L fLambda, size_t numIndices)
+{
+	size_t numThreads = getNumCores();
+	vector<thread> threads;
+	threads.reserve(numThreads);
+	for (size_t threadNum = 0; threadNum < numThreads; threadNum++) {
+		threads.push_back(thread([&fLambda, numIndices, threadNum, numThreads]() {
+			for (size_t index = threadNum; index < numIndices; index += numThreads) {
+				if (!fLambda(index))
+					break;
+			}
+		}));
+	}
+
+	for (auto& t : threads)
+		t.join();
+}
+
+template<class F>
+double microsPerCall(size_t numCalls, F f)
+{
+	auto start = chrono::steady_clock::now();
+	for (size_t i = 0; i < numCalls; i++)
+		f();
+	auto end = chrono::steady_clock::now();
+
+	return chrono::duration<double, micro>(end - start).count() / numCalls;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const size_t numCalls = 2000;
+	const size_t numIndices = getNumCores();
+	atomic<size_t> sum = 0;
+
+	auto work = [&sum](size_t index)->bool {
+		sum.fetch_add(index, memory_order_relaxed);
+		return true;
+	};
+
+	auto firstStart = chrono::steady_clock::now();
+	runLambda(work, numIndices, true);
+	double firstCall = chrono::duration<double, micro>(chrono::steady_clock::now() - firstStart).count();
+
+	double spawned = microsPerCall(numCalls, [&]() { spawnLambda(work, numIndices); });
+	double pooled = microsPerCall(numCalls, [&]() { runLambda(work, numIndices, true); });
+
+	cout << "threads, spawn us/call, pooled us/call, first pooled call us, speedup\n";
+	cout << getNumCores() << ", " << spawned << ", " << pooled << ", " << firstCall << ", " << spawned / pooled << "\n";
+
+	shutdown();
+	return 0;
+}
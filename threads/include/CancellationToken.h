@@ -0,0 +1,76 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include "defines.h"
+#include <atomic>
+#include <memory>
+
+namespace MultiCore
+{
+
+/*
+	Shared cancel flag for ThreadPool::run, runSub and runLambda.
+
+	Copies share one flag, keep one to cancel from outside and capture another in the lambda to cancel from a task.
+	Workers check it before every index and stop taking work once it is set, run then returns false. Work already
+	inside the lambda finishes, long steps can poll isCancelled() themselves.
+*/
+
+class CancellationToken {
+public:
+	CancellationToken();
+
+	void cancel() const;
+	bool isCancelled() const;
+	void reset() const;
+
+private:
+	_STD shared_ptr<_STD atomic<bool>> _pCancelled;
+};
+
+inline CancellationToken::CancellationToken()
+	: _pCancelled(_STD make_shared<_STD atomic<bool>>(false))
+{
+}
+
+inline void CancellationToken::cancel() const
+{
+	_pCancelled->store(true, _STD memory_order_release);
+}
+
+inline bool CancellationToken::isCancelled() const
+{
+	return _pCancelled->load(_STD memory_order_relaxed);
+}
+
+inline void CancellationToken::reset() const
+{
+	_pCancelled->store(false, _STD memory_order_release);
+}
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include "defines.h"
+#include <string>
+#include <vector>
+
+namespace MultiCore
+{
+
+/*
+	Logical CPUs the process may run on and how they share hardware.
+
+	On Linux the allowed set comes from sched_getaffinity and the layout from /sys/devices/system/cpu: package, core,
+	SMT siblings and the L3 cache each CPU shares. Elsewhere, or if sysfs can't be read, every CPU up to
+	hardware_concurrency is reported as its own core.
+
+	getNumCores() still returns hardware_concurrency, which counts SMT siblings. Use getNumPhysicalCores() to size FP
+	heavy work, where siblings add little.
+*/
+
+struct CpuInfo {
+	int _cpu = 0;		// OS logical CPU number
+	int _socket = 0;
+	int _core = 0;		// Unique across sockets
+	int _smtIndex = 0;	// 0 for the first logical CPU on its core, 1... for its SMT siblings
+	int _l3Domain = 0;	// Lowest CPU number sharing this CPU's L3
+};
+
+// Which CPUs a ThreadPool's workers may use and whether to pin them
+struct PlacementOptions {
+	bool _pinThreads = false;
+	bool _skipSmtSiblings = false;	// One worker per physical core
+	_STD vector<int> _reservedCpus;	// Never used, e.g. { 0 } for the servo loop
+};
+
+class CpuTopology {
+public:
+	static const CpuTopology& get();
+
+	CpuTopology();
+
+	const _STD vector<CpuInfo>& getCpus() const;
+	size_t getNumLogicalCpus() const;
+	size_t getNumPhysicalCores() const;
+	size_t getNumSockets() const;
+	size_t getNumL3Domains() const;
+
+	// Allowed CPUs after the options are applied, spread over sockets and L3 domains round robin so a small pool
+	// doesn't crowd onto one cache
+	_STD vector<CpuInfo> selectCpus(const PlacementOptions& options) const;
+
+	_STD string report() const;
+
+	static bool pinCurrentThread(int cpu);
+
+private:
+	void discover();
+	void discoverFallback();
+
+	_STD vector<CpuInfo> _cpus;
+	size_t _numPhysicalCores = 0, _numSockets = 0, _numL3Domains = 0;
+};
+
+inline const _STD vector<CpuInfo>& CpuTopology::getCpus() const
+{
+	return _cpus;
+}
+
+inline size_t CpuTopology::getNumLogicalCpus() const
+{
+	return _cpus.size();
+}
+
+inline size_t CpuTopology::getNumPhysicalCores() const
+{
+	return _numPhysicalCores;
+}
+
+inline size_t CpuTopology::getNumSockets() const
+{
+	return _numSockets;
+}
+
+inline size_t CpuTopology::getNumL3Domains() const
+{
+	return _numL3Domains;
+}
+
+inline size_t getNumPhysicalCores()
+{
+	return CpuTopology::get().getNumPhysicalCores();
+}
+
+}
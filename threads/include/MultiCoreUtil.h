@@ -50,152 +50,52 @@
 #include <algorithm>
 #include <mutex>
 #include <thread>
-#include <condition_variable>
+#include <atomic>
 #include <functional>
+#include <type_traits>
+#include <deque>
+#include <memory>
+#include <RangeScheduler.h>
+#include <CancellationToken.h>
+#include <CpuTopology.h>
+#include <PoolStats.h>
 
 namespace MultiCore {
 
+	template<class T>
+	class PoolFuture;
+	class PoolScheduleAwaiter;
+
 	inline int getNumCores()
 	{
-		static int numCores = -1;
-		if (numCores == -1) {
-			numCores = _STD thread::hardware_concurrency();
-		}
+		static const int numCores = _STD thread::hardware_concurrency(); // Magic static, workers call this too
 		return numCores;
 	}
 
-	template<class L>
-	void runLambda(L fLambda, bool multiCore)
-	{
-		if (multiCore) {
-			size_t numCores = getNumCores();
-			_STD vector<_STD thread> threads;
-			threads.reserve(numCores);
-			for (size_t i = 0; i < numCores; i++) {
-				threads.push_back(_STD move(_STD thread(fLambda, i, numCores)));
-			}
-
-			for (size_t i = 0; i < threads.size(); i++) {
-				threads[i].join();
-			}
-		}
-		else {
-			fLambda(0, 1);
-		}
-	}
-
-	template<class L>
-	void runLambda(size_t numCores, L fLambda, bool multiCore)
-	{
-		if (multiCore) {
-			_STD vector<_STD thread> threads;
-			threads.reserve(numCores);
-			for (size_t i = 0; i < numCores; i++) {
-				threads.push_back(_STD move(_STD thread(fLambda, i, numCores)));
-			}
-
-			for (size_t i = 0; i < threads.size(); i++) {
-				threads[i].join();
-			}
-		}
-		else {
-			fLambda(0, 1);
-		}
-	}
-
-	template<class L>
-	void runLambda(L fLambda, _STD vector<size_t>& indexPool, bool multiCore)
-	{
-		if (multiCore) {
-			_STD mutex indexPoolMutex;
-
-			size_t numThreads = getNumCores();
-			_STD vector<_STD thread> threads;
-			threads.reserve(numThreads);
-			for (size_t i = 0; i < numThreads; i++) {
-				auto outerLambda = [fLambda, &indexPool, &indexPoolMutex]() {
-					size_t index = 0;
-					while (index != -1) {
-						index = -1;
-						{
-							_STD lock_guard<_STD mutex> lock(indexPoolMutex); // Tested that mutex overhead is minimal.
-							if (!indexPool.empty()) {
-								index = indexPool.back();
-								indexPool.pop_back();
-							}
-							else
-								break;
-						}
-
-						if (index != -1)
-							if (!fLambda(index))
-								break;
-					}
-				};
-
-				threads.push_back(std::move(_STD thread(outerLambda)));
-			}
-
-			for (size_t i = 0; i < threads.size(); i++) {
-				threads[i].join();
-			}
-		}
-		else {
-			for (size_t index : indexPool)
-				if (index != -1)
-					if (!fLambda(index))
-						break;
-		}
-	}
-
-	template<class L>
-	void runLambda(L fLambda, size_t numIndices, bool multiCore)
-	{
-		if (multiCore) {
-			size_t numThreads = getNumCores();
-			_STD vector<_STD thread> threads;
-			threads.reserve(numThreads);
-			for (size_t threadNum = 0; threadNum < numThreads; threadNum++) {
-				auto outerLambda = [fLambda, numIndices, threadNum, numThreads]() {
-					for (size_t index = threadNum; index < numIndices; index += numThreads) {
-						if (!fLambda(index))
-							break;
-					}
-				};
-
-				threads.push_back(std::move(_STD thread(outerLambda)));
-			}
-
-			for (size_t i = 0; i < threads.size(); i++) {
-				threads[i].join();
-			}
-		} else {
-			for (size_t index = 0; index < numIndices; index++)
-				if (!fLambda(index))
-					break;
-		}
-	}
-
 class ThreadPool {
-private:
-	enum Stage {
-		AT_NOT_CREATED,
-		AT_STOPPED,
-		AT_RUNNING,
-		AT_TERMINATED,
-	};
-
 public:
 	class Thread;
 	using FuncType = _STD function<bool (size_t threadNum, size_t idx)>;
+	using TaskType = _STD function<void()>;
 
 	ThreadPool(size_t numThreads, size_t numSubThreads, size_t numAvailable);
 
+	// Workers are placed on CpuTopology::selectCpus(placement), worker i on cpu (i + 1) % n leaving the first for the
+	// caller, and pinned there if placement asks for it. A thread count of 0 means one per selected cpu, an allocated
+	// count of 0 one worker per selected cpu after the caller's, so none if only one cpu is selected. Past n - 1
+	// workers the placement wraps around, worker n - 1 shares the caller's cpu. If no cpu is left, e.g. all are
+	// reserved, no workers are started at all and getPlacementReport says so.
+	ThreadPool(size_t numThreads, size_t numSubThreads, size_t numAvailable, const PlacementOptions& placement);
+
 	~ThreadPool();
 
 	inline size_t getNumAllocatedThreads() const;
 	inline size_t getNumThreads() const;
 
+	// Cpu of each allocated worker, empty if the pool was built without PlacementOptions
+	const _STD vector<CpuInfo>& getWorkerPlacement() const;
+	_STD string getPlacementReport() const;
+
 	template<class L>
 	void run(size_t numSteps, const L& f, bool multiCore);
 	template<class L>
@@ -212,36 +112,125 @@ public:
 	template<class L>
 	void run(size_t numThreads, size_t numSteps, const L& f, bool multiCore) const;
 
+	// If f throws, the first exception stops the remaining indices, as if cancelled, and is rethrown from run or runSub
+	// once every thread has left f. Later exceptions from the same run are dropped.
+
+	// run and runSub may be called from inside another run of the same pool. The calling thread takes part in the
+	// nested run and picks up whichever workers are idle, no threads are created so the thread count stays bounded.
+	// Nested runs with a DYNAMIC, GUIDED or STEALING partitioner also take in threads of the same outer run as those
+	// run out of work, and a thread waiting for its workers helps them instead of sleeping.
+
+	// Same as above with the index range divided by part instead of the default stride, see RangeScheduler.h
+	template<class L>
+	void run(size_t numSteps, const L& f, bool multiCore, const Partitioner& part) const;
+
+	template<class L>
+	void runSub(size_t numSteps, size_t minStepsToMultiThread, const L& f, bool multiCore, const Partitioner& part) const;
+
+	// Stops handing out indices once cancel is set, by the caller from outside or by f itself. Returns true if every
+	// index was run, false if the run was cancelled. See CancellationToken.h
+	template<class L>
+	bool run(size_t numSteps, const L& f, bool multiCore, const CancellationToken& cancel, const Partitioner& part = Partitioner()) const;
+
+	template<class L>
+	bool runSub(size_t numSteps, size_t minStepsToMultiThread, const L& f, bool multiCore, const CancellationToken& cancel, const Partitioner& part = Partitioner()) const;
+
+	// Runs f(threadNum) for threadNum 0 to numThreads - 1 on numThreads threads that all run at the same time, so they
+	// may wait for each other. Uses idle workers if there are enough of them, otherwise starts threads of its own.
+	template<class L>
+	void runConcurrent(size_t numThreads, const L& f) const;
+
+	// Runs f() on the pool and returns immediately, see PoolFuture.h
+	template<class F>
+	PoolFuture<_STD invoke_result_t<F>> submit(F f) const;
+
+	// run(numSteps, f, true) without blocking the caller. f is copied, anything it references must outlive the future.
+	template<class L>
+	PoolFuture<void> runAsync(size_t numSteps, L f) const;
+
+	// co_await pool.schedule() continues the coroutine on a pool thread, see PoolTask.h
+	PoolScheduleAwaiter schedule() const;
+
+	// Queues task to run on an idle worker, FIFO. Workers finishing a run pick up queued tasks too.
+	// task must not throw, use submit to get its exception back through the future. Tasks still queued when the pool
+	// is destroyed run on the destroying thread first, so nothing waiting on them is left blocked.
+	void enqueue(TaskType task) const;
+
+	// Runs one queued task on the calling thread, returns false if there was none. Threads waiting on queued work
+	// call this instead of sleeping.
+	bool runPendingTask() const;
+
+	// Instrumentation, off by default, see PoolStats.h. Turning it on resets the counters. When off it costs one
+	// relaxed load per run, chunk loop and task. On, it takes two steady_clock reads per chunk and task; trace also
+	// keeps each chunk, task, run, wait and idle period for PoolStats::writeChromeTrace.
+	// Only change it while no run is in flight, getStats may be called at any time.
+	void enableStats(bool enable, bool trace = false) const;
+	bool isStatsEnabled() const;
+	PoolStats getStats() const;
+	void resetStats() const;
+
 private:
-	void start(size_t numAllocatedThreads);
+	ThreadPool(size_t numThreads, size_t numSubThreads, size_t numAvailable, const PlacementOptions& placement, const _STD vector<CpuInfo>& cpus);
+	void start(size_t numAllocatedThreads, bool pinThreads);
 
 	void stop();
 
-	void acquireThreads(size_t numRequested, size_t numSteps, size_t minStepsToMultiThread, const FuncType& func, _STD vector<Thread*>& ourThreads) const;
-	void releaseThread(Thread* pThread) const;
-
-	bool atStage(const _STD vector<Thread*>& ourThreads, Stage st) const;
+	void acquireThreads(size_t numRequested, size_t numSteps, size_t minStepsToMultiThread, _STD vector<Thread*>& ourThreads) const;
+	bool acquireAllThreads(size_t numRequested, _STD vector<Thread*>& ourThreads) const;
+	void releaseThreads(const _STD vector<Thread*>& ourThreads) const;
+	void wakeThreadForTasks() const;
+	void dispatch(Thread* pThread) const;
 
-	bool atStage(const _STD vector<Thread*>& ourThreads, Stage st0, Stage st1) const;
+	struct Job;
+	struct StatsSlot;
+	struct ChunkTimer;
 
-	void setStageForAll(const _STD vector<Thread*>& ourThreads, Stage st) const;
+	enum StatsMode {
+		STATS_OFF,
+		STATS_ON,
+		STATS_TRACE,
+	};
 
-	void setStageFromWorkerThread(Stage st, Thread* pThread) const;
+	bool runFunc_private(size_t numThreads, size_t numSteps, size_t minStepsToMultiThread, const FuncType& func, const Partitioner& part, _STD vector<Thread*>& ourThreads, const CancellationToken* pCancel = nullptr) const;
+	bool runFunc_acquired(size_t numThreads, size_t numSteps, const FuncType& func, const Partitioner& part, _STD vector<Thread*>& ourThreads, const CancellationToken* pCancel) const;
+	void runConcurrent_private(size_t numThreads, const FuncType& func) const;
+	void runJob(Job& job, size_t participant) const;
+	bool hasOpenJob(uint64_t rootId) const;
+	bool helpOpenJob(uint64_t rootId) const;
 
-	void runFunc_private(size_t numThreads, size_t numSteps, size_t minStepsToMultiThread, const FuncType& func, _STD vector<Thread*>& ourThreads) const;
+	StatsSlot& getStatsSlot() const;
+	void recordEvent(StatsSlot& slot, PoolTraceEvent::Kind kind, uint64_t startNs, uint64_t endNs, uint64_t runId = 0, size_t begin = 0, size_t end = 0) const;
+	void recordRun(const Job& job, size_t numSteps, size_t numParticipants, uint64_t startNs, uint64_t waitStartNs, uint64_t busyNsBefore) const;
 
 	static void runSingleThreadStat(ThreadPool* pSelf, Thread* pThread);
 
 	void runSingleThread(Thread* pThread);
 
-	bool _running = true;
+	_STD atomic<bool> _running = true;
 	const size_t _numThreads, _numSubThreads;
+	_STD vector<CpuInfo> _workerPlacement;
+	bool _pinned = false;
+	bool _noCpusSelected = false;
+
+	mutable _STD mutex _stackMutex, _taskMutex;
+	mutable _STD deque<TaskType> _tasks;
+	mutable _STD atomic<size_t> _numTasks = 0;
 
-	mutable _STD condition_variable _cv;
-	mutable _STD mutex _stageMutex, _stackMutex;
+	// Nested runs that threads of the same outer run may join
+	mutable _STD mutex _jobMutex;
+	mutable _STD vector<Job*> _openJobs;
+	mutable _STD atomic<size_t> _numOpenJobs = 0;
 
 	_STD vector<Thread*> _allocatedThreads;
 	mutable _STD vector<Thread*> _availThreads;
+
+	// Instrumentation. Slot 0 is for threads outside the pool, slot i + 1 for _allocatedThreads[i].
+	mutable _STD atomic<int> _statsMode = STATS_OFF;
+	mutable _STD atomic<uint64_t> _statsEpochNs = 0;
+	mutable _STD atomic<uint64_t> _nextRunId = 1;
+	_STD vector<_STD unique_ptr<StatsSlot>> _statsSlots;
+	mutable _STD mutex _statsMutex;
+	mutable _STD deque<PoolRunStats> _runStats;
 };
 
 inline size_t ThreadPool::getNumAllocatedThreads() const
@@ -254,13 +243,18 @@ inline size_t ThreadPool::getNumThreads() const
 	return _numThreads;
 }
 
+inline const _STD vector<CpuInfo>& ThreadPool::getWorkerPlacement() const
+{
+	return _workerPlacement;
+}
+
 template<class L>
 inline void ThreadPool::run(size_t numSteps, const L& f, bool multiCore) {
 	if (multiCore) {
 		// In primary thread
 		FuncType wrapper(f);
 		_STD vector<Thread*> ourThreads;
-		runFunc_private(_numThreads, numSteps, -1, wrapper, ourThreads);
+		runFunc_private(_numThreads, numSteps, -1, wrapper, Partitioner(), ourThreads);
 	} else {
 		for (size_t i = 0; i < numSteps; i++) {
 			if (!f(0, i))
@@ -275,7 +269,7 @@ inline void ThreadPool::run(size_t numSteps, const L& f, bool multiCore) const {
 		// In primary thread
 		FuncType wrapper(f);
 		_STD vector<Thread*> ourThreads;
-		runFunc_private(_numThreads, numSteps, -1, wrapper, ourThreads);
+		runFunc_private(_numThreads, numSteps, -1, wrapper, Partitioner(), ourThreads);
 	} else {
 		for (size_t i = 0; i < numSteps; i++) {
 			if (!f(0, i))
@@ -290,7 +284,7 @@ inline void ThreadPool::runSub(size_t numSteps, size_t minStepsToMultiThread, co
 		// In primary thread
 		FuncType wrapper(f);
 		_STD vector<Thread*> ourThreads;
-		runFunc_private(_numSubThreads, numSteps, minStepsToMultiThread, wrapper, ourThreads);
+		runFunc_private(_numSubThreads, numSteps, minStepsToMultiThread, wrapper, Partitioner(), ourThreads);
 	} else {
 		for (size_t i = 0; i < numSteps; i++) {
 			if (!f(0, i))
@@ -305,7 +299,7 @@ inline void ThreadPool::runSub(size_t numSteps, size_t minStepsToMultiThread, co
 		// In primary thread
 		FuncType wrapper(f);
 		_STD vector<Thread*> ourThreads;
-		runFunc_private(_numSubThreads, numSteps, minStepsToMultiThread, wrapper, ourThreads);
+		runFunc_private(_numSubThreads, numSteps, minStepsToMultiThread, wrapper, Partitioner(), ourThreads);
 	} else {
 		for (size_t i = 0; i < numSteps; i++) {
 			if (!f(0, i))
@@ -320,7 +314,7 @@ inline void ThreadPool::run(size_t numThreads, size_t numSteps, const L& f, bool
 		// In primary thread
 		FuncType wrapper(f);
 		_STD vector<Thread*> ourThreads;
-		runFunc_private(false, numThreads, numSteps, wrapper, ourThreads);
+		runFunc_private(numThreads, numSteps, -1, wrapper, Partitioner(), ourThreads);
 	} else {
 		for (size_t i = 0; i < numSteps; i++) {
 			if (!f(0, i))
@@ -335,7 +329,37 @@ inline void ThreadPool::run(size_t numThreads, size_t numSteps, const L& f, bool
 		// In primary thread
 		FuncType wrapper(f);
 		_STD vector<Thread*> ourThreads;
-		runFunc_private(false, numThreads, numSteps, wrapper, ourThreads);
+		runFunc_private(numThreads, numSteps, -1, wrapper, Partitioner(), ourThreads);
+	} else {
+		for (size_t i = 0; i < numSteps; i++) {
+			if (!f(0, i))
+				break;
+		}
+	}
+}
+
+template<class L>
+inline void ThreadPool::run(size_t numSteps, const L& f, bool multiCore, const Partitioner& part) const {
+	if (multiCore) {
+		// In primary thread
+		FuncType wrapper(f);
+		_STD vector<Thread*> ourThreads;
+		runFunc_private(_numThreads, numSteps, -1, wrapper, part, ourThreads);
+	} else {
+		for (size_t i = 0; i < numSteps; i++) {
+			if (!f(0, i))
+				break;
+		}
+	}
+}
+
+template<class L>
+inline void ThreadPool::runSub(size_t numSteps, size_t minStepsToMultiThread, const L& f, bool multiCore, const Partitioner& part) const {
+	if (multiCore && numSteps >= minStepsToMultiThread) {
+		// In primary thread
+		FuncType wrapper(f);
+		_STD vector<Thread*> ourThreads;
+		runFunc_private(_numSubThreads, numSteps, minStepsToMultiThread, wrapper, part, ourThreads);
 	} else {
 		for (size_t i = 0; i < numSteps; i++) {
 			if (!f(0, i))
@@ -344,5 +368,182 @@ inline void ThreadPool::run(size_t numThreads, size_t numSteps, const L& f, bool
 	}
 }
 
+template<class L>
+inline void ThreadPool::runConcurrent(size_t numThreads, const L& f) const {
+	FuncType wrapper([&f](size_t, size_t i)->bool {
+		f(i);
+		return true;
+	});
+	runConcurrent_private(numThreads, wrapper);
+}
+
+template<class L>
+inline bool ThreadPool::run(size_t numSteps, const L& f, bool multiCore, const CancellationToken& cancel, const Partitioner& part) const {
+	if (multiCore) {
+		// In primary thread
+		FuncType wrapper(f);
+		_STD vector<Thread*> ourThreads;
+		return runFunc_private(_numThreads, numSteps, -1, wrapper, part, ourThreads, &cancel);
+	} else {
+		for (size_t i = 0; i < numSteps; i++) {
+			if (cancel.isCancelled() || !f(0, i))
+				break;
+		}
+		return !cancel.isCancelled();
+	}
+}
+
+template<class L>
+inline bool ThreadPool::runSub(size_t numSteps, size_t minStepsToMultiThread, const L& f, bool multiCore, const CancellationToken& cancel, const Partitioner& part) const {
+	if (multiCore && numSteps >= minStepsToMultiThread) {
+		// In primary thread
+		FuncType wrapper(f);
+		_STD vector<Thread*> ourThreads;
+		return runFunc_private(_numSubThreads, numSteps, minStepsToMultiThread, wrapper, part, ourThreads, &cancel);
+	} else {
+		for (size_t i = 0; i < numSteps; i++) {
+			if (cancel.isCancelled() || !f(0, i))
+				break;
+		}
+		return !cancel.isCancelled();
+	}
+}
+
+	// The runLambda functions run on a process wide ThreadPool, created on first use with getNumCores() threads,
+	// instead of launching threads on every call.
+	// configureGlobalPool replaces it with one of numThreads threads, shutdown joins its threads. The next runLambda
+	// recreates it. Neither may be called while a runLambda is in flight.
+	ThreadPool& getGlobalPool();
+	void configureGlobalPool(size_t numThreads);
+	void shutdown();
+
+	// fLambda(threadNum, numCores) runs on numCores threads at once, as it always has, so the calls may wait for each
+	// other. See ThreadPool::runConcurrent.
+	template<class L>
+	void runLambda(size_t numCores, L fLambda, bool multiCore)
+	{
+		if (multiCore) {
+			getGlobalPool().runConcurrent(numCores, [&fLambda, numCores](size_t threadNum) {
+				fLambda(threadNum, numCores);
+			});
+		}
+		else {
+			fLambda(0, 1);
+		}
+	}
+
+	template<class L>
+	void runLambda(L fLambda, bool multiCore)
+	{
+		if (multiCore)
+			runLambda(getGlobalPool().getNumThreads(), fLambda, multiCore);
+		else
+			fLambda(0, 1);
+	}
+
+	// Each thread takes indices from the back of indexPool until it is empty, -1 entries are skipped. A thread stops
+	// when fLambda returns false, the others carry on. indexPool is consumed, whatever no thread took is left in it.
+	// Threads claim batchSize entries at a time from an atomic cursor. The rest of a stopped thread's batch goes back
+	// into indexPool.
+	template<class L>
+	void runLambda(L fLambda, _STD vector<size_t>& indexPool, bool multiCore, size_t batchSize = 1)
+	{
+		if (multiCore) {
+			const size_t numEntries = indexPool.size();
+			batchSize = _STD max(batchSize, (size_t)1);
+			alignas(64) _STD atomic<size_t> numClaimed = 0;
+
+			auto& pool = getGlobalPool();
+			size_t numThreads = pool.getNumThreads();
+
+			// A participant may be handed several steps, once it has stopped it skips the rest
+			_STD vector<char> stopped(numThreads, 0);
+			_STD mutex leftoverMutex;
+			_STD vector<size_t> leftovers;
+
+			pool.run(numThreads, numThreads, [&fLambda, &indexPool, &numClaimed, &stopped, &leftoverMutex, &leftovers, numEntries, batchSize](size_t threadNum, size_t)->bool {
+				if (stopped[threadNum])
+					return true;
+
+				while (true) {
+					size_t first = numClaimed.fetch_add(batchSize, _STD memory_order_relaxed);
+					if (first >= numEntries)
+						break;
+
+					size_t last = _STD min(first + batchSize, numEntries);
+					for (size_t j = first; j < last; j++) {
+						size_t index = indexPool[numEntries - 1 - j];
+						if (index != (size_t)-1 && !fLambda(index)) {
+							stopped[threadNum] = 1;
+
+							_STD lock_guard<_STD mutex> lock(leftoverMutex);
+							for (size_t k = last; k-- > j + 1; )
+								leftovers.push_back(indexPool[numEntries - 1 - k]);
+							return true;
+						}
+					}
+				}
+				return true;
+			}, true);
+
+			indexPool.resize(numEntries - _STD min(numClaimed.load(_STD memory_order_relaxed), numEntries));
+			indexPool.insert(indexPool.end(), leftovers.begin(), leftovers.end());
+		}
+		else {
+			for (size_t index : indexPool)
+				if (index != (size_t)-1)
+					if (!fLambda(index))
+						break;
+		}
+	}
+
+	template<class L>
+	void runLambda(L fLambda, size_t numIndices, bool multiCore)
+	{
+		if (multiCore) {
+			getGlobalPool().run(numIndices, [&fLambda](size_t, size_t index)->bool {
+				return fLambda(index);
+			}, true);
+		} else {
+			for (size_t index = 0; index < numIndices; index++)
+				if (!fLambda(index))
+					break;
+		}
+	}
+
+	// Same as above with the indices divided by part instead of interleaved. Partitioner::staticBlocks keeps
+	// neighbouring indices on the same thread.
+	template<class L>
+	void runLambda(L fLambda, size_t numIndices, bool multiCore, const Partitioner& part)
+	{
+		if (multiCore) {
+			getGlobalPool().run(numIndices, [&fLambda](size_t threadNum, size_t index)->bool {
+				return fLambda(index);
+			}, true, part);
+		} else {
+			for (size_t index = 0; index < numIndices; index++)
+				if (!fLambda(index))
+					break;
+		}
+	}
+
+	// Stops early once cancel is set, fLambda may set it too. Returns false if cancelled, see CancellationToken.h
+	template<class L>
+	bool runLambda(L fLambda, size_t numIndices, bool multiCore, const CancellationToken& cancel, const Partitioner& part = Partitioner())
+	{
+		if (multiCore) {
+			return getGlobalPool().run(numIndices, [&fLambda](size_t threadNum, size_t index)->bool {
+				return fLambda(index);
+			}, true, cancel, part);
+		} else {
+			for (size_t index = 0; index < numIndices; index++)
+				if (cancel.isCancelled() || !fLambda(index))
+					break;
+			return !cancel.isCancelled();
+		}
+	}
+
 } // namespace MultiCore
 
+#include <PoolFuture.h>
+#include <PoolTask.h>
@@ -0,0 +1,270 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <assert.h>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <vector>
+#include <MultiCoreUtil.h>
+
+namespace MultiCore
+{
+
+/*
+	Result of ThreadPool::submit and runAsync. Copies share one reference counted state, like std::shared_future.
+
+	wait() and get() run queued pool tasks on the calling thread while the result isn't ready, they only sleep when
+	there is nothing to help with. then(f) queues f on the pool once the result is ready, f takes the result (or
+	nothing for PoolFuture<void>) and the returned future holds f's result.
+
+	get() returns a reference to the stored result, it stays valid as long as a copy of the future does. take() moves
+	the result out instead, for move only results or to save a copy, and may only be used by the future's one owner.
+	Any later get() or take() sees the moved from value.
+
+	An exception thrown by the task is stored instead of a result and rethrown by get() and take(). then(f) skips f
+	and passes the exception on to its own future.
+*/
+
+// Result storage for PoolFuture, void has none
+template<class T>
+struct PoolFutureValue {
+	using GetType = const T&;
+
+	_STD optional<T> _value;
+
+	template<class F>
+	void set(F& f) {
+		_value.emplace(f());
+	}
+
+	const T& get() const {
+		return *_value;
+	}
+
+	T take() {
+		return _STD move(*_value);
+	}
+};
+
+template<>
+struct PoolFutureValue<void> {
+	using GetType = void;
+
+	template<class F>
+	void set(F& f) {
+		f();
+	}
+
+	void get() const {
+	}
+
+	void take() {
+	}
+};
+
+template<class T>
+class PoolFuture {
+public:
+	using ValueType = T;
+
+	PoolFuture() = default;
+
+	bool valid() const;
+	bool isReady() const;
+	void wait() const;
+	typename PoolFutureValue<T>::GetType get() const;
+	T take();
+
+	template<class F>
+	auto then(F f) const;
+
+private:
+	template<class U>
+	friend class PoolFuture;
+	friend class ThreadPool;
+
+	struct State {
+		State(const ThreadPool& pool);
+
+		const ThreadPool& _pool;
+		_STD atomic<uint32_t> _ready = 0;
+		PoolFutureValue<T> _value;
+		_STD exception_ptr _exception;
+		_STD mutex _mutex;
+		_STD vector<ThreadPool::TaskType> _continuations;
+	};
+
+	PoolFuture(const _STD shared_ptr<State>& pState);
+
+	// Runs f, stores its result and queues the continuations
+	template<class F>
+	static void complete(const _STD shared_ptr<State>& pState, F& f);
+
+	_STD shared_ptr<State> _pState;
+};
+
+template<class T>
+PoolFuture<T>::State::State(const ThreadPool& pool)
+	: _pool(pool)
+{
+}
+
+template<class T>
+PoolFuture<T>::PoolFuture(const _STD shared_ptr<State>& pState)
+	: _pState(pState)
+{
+}
+
+template<class T>
+inline bool PoolFuture<T>::valid() const
+{
+	return _pState != nullptr;
+}
+
+template<class T>
+inline bool PoolFuture<T>::isReady() const
+{
+	return _pState && _pState->_ready.load(_STD memory_order_acquire) != 0;
+}
+
+template<class T>
+void PoolFuture<T>::wait() const
+{
+	if (!_pState)
+		return;
+
+	while (!_pState->_ready.load(_STD memory_order_acquire)) {
+		if (!_pState->_pool.runPendingTask())
+			_pState->_ready.wait(0, _STD memory_order_acquire);
+	}
+}
+
+template<class T>
+typename PoolFutureValue<T>::GetType PoolFuture<T>::get() const
+{
+	wait();
+	if (_pState->_exception)
+		_STD rethrow_exception(_pState->_exception);
+	return _pState->_value.get();
+}
+
+template<class T>
+T PoolFuture<T>::take()
+{
+	wait();
+	if (_pState->_exception)
+		_STD rethrow_exception(_pState->_exception);
+	return _pState->_value.take();
+}
+
+template<class T>
+template<class F>
+void PoolFuture<T>::complete(const _STD shared_ptr<State>& pState, F& f)
+{
+	try {
+		pState->_value.set(f);
+	} catch (...) {
+		// Don't let it reach the worker's thread function, the future's owner gets it from get()
+		pState->_exception = _STD current_exception();
+	}
+
+	_STD vector<ThreadPool::TaskType> continuations;
+	{
+		_STD lock_guard lg(pState->_mutex);
+		pState->_ready.store(1, _STD memory_order_release);
+		continuations.swap(pState->_continuations);
+	}
+	pState->_ready.notify_all();
+
+	for (auto& task : continuations)
+		pState->_pool.enqueue(_STD move(task));
+}
+
+template<class T>
+template<class F>
+auto PoolFuture<T>::then(F f) const
+{
+	assert(_pState);
+
+	auto body = [pSrc = _pState, f]() mutable {
+		if (pSrc->_exception)
+			_STD rethrow_exception(pSrc->_exception);
+		if constexpr (_STD is_void_v<T>)
+			return f();
+		else
+			return f(pSrc->_value.get()); // By reference, other copies of the source may still get() it
+	};
+
+	using ResultType = decltype(body());
+	auto pDst = _STD make_shared<typename PoolFuture<ResultType>::State>(_pState->_pool);
+	ThreadPool::TaskType task = [pDst, body]() mutable {
+		PoolFuture<ResultType>::complete(pDst, body);
+	};
+
+	bool ready;
+	{
+		_STD lock_guard lg(_pState->_mutex);
+		ready = _pState->_ready.load(_STD memory_order_acquire) != 0;
+		if (!ready)
+			_pState->_continuations.push_back(task);
+	}
+
+	if (ready)
+		_pState->_pool.enqueue(_STD move(task));
+
+	return PoolFuture<ResultType>(pDst);
+}
+
+template<class F>
+PoolFuture<_STD invoke_result_t<F>> ThreadPool::submit(F f) const
+{
+	using ResultType = _STD invoke_result_t<F>;
+	using FutureType = PoolFuture<ResultType>;
+
+	auto pState = _STD make_shared<typename FutureType::State>(*this);
+	enqueue([pState, f]() mutable {
+		FutureType::complete(pState, f);
+	});
+
+	return FutureType(pState);
+}
+
+template<class L>
+PoolFuture<void> ThreadPool::runAsync(size_t numSteps, L f) const
+{
+	// The task's thread owns the run, idle workers join it as usual
+	return submit([this, numSteps, f]() {
+		run(numSteps, f, true);
+	});
+}
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include "defines.h"
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#define POOL_STATS_MAX_RUNS 4096
+#define POOL_TRACE_MAX_EVENTS (1024 * 1024) // Per thread, later events are counted in _numDroppedEvents
+
+namespace MultiCore
+{
+
+/*
+	Snapshot of a ThreadPool's instrumentation, see ThreadPool::enableStats.
+
+	Times are steady_clock nanoseconds since stats were enabled or last reset. Worker 0 is every thread outside the
+	pool that called run, runSub or runPendingTask, worker i + 1 is the pool's thread i.
+
+	busy	inside the run's function or a queued task
+	wait	taking part in a run without running the function: getting chunks, stealing, waiting for the other threads
+	idle	pool threads parked between runs and tasks
+
+	Time spent in nested runs is counted once, as busy time of the enclosing chunk.
+*/
+
+struct PoolWorkerStats {
+	uint64_t _busyNs = 0;
+	uint64_t _waitNs = 0;
+	uint64_t _idleNs = 0;
+	size_t _numChunks = 0;
+	size_t _numTasks = 0;
+};
+
+struct PoolRunStats {
+	uint64_t _runId = 0;
+	uint64_t _startNs = 0;
+	uint64_t _wallNs = 0;
+	size_t _numSteps = 0;
+	size_t _numParticipants = 0; // Including the caller and any helpers that joined a nested run
+	uint64_t _busyNs = 0; // Summed over participants
+	uint64_t _maxBusyNs = 0; // Of the busiest participant
+
+	// Busiest participant over the mean, 1 when the work was spread evenly, _numParticipants when one did it all
+	double getImbalance() const;
+};
+
+struct PoolTraceEvent {
+	enum Kind {
+		RUN,
+		CHUNK,
+		TASK,
+		WAIT,
+		IDLE,
+	};
+
+	Kind _kind;
+	size_t _worker;
+	uint64_t _startNs;
+	uint64_t _durationNs;
+	uint64_t _runId; // RUN, CHUNK and WAIT
+	size_t _begin, _end; // CHUNK index range, RUN number of steps in _end
+};
+
+struct PoolStats {
+	_STD vector<PoolWorkerStats> _workers;
+	_STD vector<PoolRunStats> _runs; // The latest POOL_STATS_MAX_RUNS, in the order they finished
+	_STD vector<PoolTraceEvent> _events; // Only when tracing, ordered by worker then time
+	size_t _numDroppedEvents = 0;
+
+	double getMeanImbalance() const;
+
+	// Chrome trace_event JSON, open in chrome://tracing or ui.perfetto.dev
+	void writeChromeTrace(_STD ostream& out) const;
+	bool writeChromeTrace(const _STD string& filename) const;
+};
+
+}
@@ -0,0 +1,618 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <assert.h>
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+#include <MultiCoreUtil.h>
+
+namespace MultiCore
+{
+
+/*
+	C++20 coroutine support for ThreadPool.
+
+	co_await pool.schedule() suspends the coroutine and queues its resumption on the pool, so everything after it
+	runs on a pool thread. A suspended coroutine holds no thread, thousands can be in flight on a small pool.
+
+	task<T> is a lazily started coroutine returning T. It starts when first awaited and resumes its awaiter on
+	whichever thread it finishes on. Exceptions are rethrown from co_await. A task is move only and awaited once.
+
+	when_all(tasks) awaits every task and returns their results, a vector for a vector of tasks and a tuple for a
+	list of them, with std::monostate standing in for void. The tasks are started one after another on the awaiting
+	thread, each runs until its first suspension, so tasks that begin with co_await pool.schedule() run in parallel.
+	If any throw, the first in argument order is rethrown once all have finished.
+
+	syncWait(pool, task) runs a task from ordinary code and returns its result. The calling thread runs queued pool
+	tasks while it waits, like PoolFuture::wait.
+
+	task<void> pipeline(const ThreadPool& pool, Mesh& mesh)
+	{
+		co_await pool.schedule();
+		auto parts = co_await when_all(tessellate(pool, mesh, 0), tessellate(pool, mesh, 1));
+		...
+	}
+*/
+
+template<class T = void>
+class task;
+
+class PoolScheduleAwaiter {
+public:
+	PoolScheduleAwaiter(const ThreadPool& pool);
+
+	bool await_ready() const noexcept;
+	void await_suspend(_STD coroutine_handle<> handle) const;
+	void await_resume() const noexcept;
+
+private:
+	const ThreadPool& _pool;
+};
+
+// Promise state shared by task<T> and task<void>
+class TaskPromiseBase {
+public:
+	struct FinalAwaiter {
+		bool await_ready() const noexcept;
+
+		template<class P>
+		_STD coroutine_handle<> await_suspend(_STD coroutine_handle<P> handle) const noexcept;
+
+		void await_resume() const noexcept;
+	};
+
+	_STD suspend_always initial_suspend() const noexcept;
+	FinalAwaiter final_suspend() const noexcept;
+	void unhandled_exception();
+
+	_STD coroutine_handle<> _continuation; // Awaiting coroutine, resumed when this one finishes
+	_STD shared_ptr<_STD atomic<uint32_t>> _pDone; // Set instead of resuming anything, for syncWait
+	_STD exception_ptr _exception;
+};
+
+template<class T>
+class TaskPromise : public TaskPromiseBase {
+public:
+	task<T> get_return_object();
+
+	template<class U>
+	void return_value(U&& value);
+
+	T getResult();
+
+private:
+	_STD optional<T> _value;
+};
+
+template<>
+class TaskPromise<void> : public TaskPromiseBase {
+public:
+	task<void> get_return_object();
+
+	void return_void() const noexcept;
+
+	void getResult();
+};
+
+template<class T>
+class task {
+public:
+	using promise_type = TaskPromise<T>;
+	using ValueType = T;
+
+	task() = default;
+	task(const task& src) = delete;
+	task(task&& src) noexcept;
+	~task();
+
+	task& operator = (const task& rhs) = delete;
+	task& operator = (task&& rhs) noexcept;
+
+	bool valid() const;
+	bool isReady() const;
+
+	// co_await t starts t if need be, suspends until it has finished and returns its result
+	auto operator co_await() && noexcept;
+	auto operator co_await() & noexcept;
+
+	// Awaits completion without taking the result or rethrowing, see when_all
+	auto whenReady() noexcept;
+
+	// Result of a finished task, rethrows its exception
+	T getResult();
+
+private:
+	friend class TaskPromise<T>;
+
+	template<class U>
+	friend U syncWait(const ThreadPool& pool, task<U> t);
+
+	struct Awaiter {
+		bool await_ready() const noexcept;
+		_STD coroutine_handle<> await_suspend(_STD coroutine_handle<> awaiting) const noexcept;
+		T await_resume() const;
+
+		_STD coroutine_handle<promise_type> _handle;
+	};
+
+	struct ReadyAwaiter : public Awaiter {
+		void await_resume() const noexcept;
+	};
+
+	explicit task(_STD coroutine_handle<promise_type> handle);
+
+	_STD coroutine_handle<promise_type> _handle;
+};
+
+// Counts down the tasks of a when_all, the last one to finish resumes the awaiting coroutine
+struct WhenAllLatch {
+	_STD atomic<size_t> _count = 0;
+	_STD coroutine_handle<> _continuation;
+};
+
+// Coroutine awaiting one task of a when_all, then counting down the latch
+class WhenAllDriver {
+public:
+	class promise_type {
+	public:
+		struct FinalAwaiter {
+			bool await_ready() const noexcept;
+			_STD coroutine_handle<> await_suspend(_STD coroutine_handle<promise_type> handle) const noexcept;
+			void await_resume() const noexcept;
+		};
+
+		WhenAllDriver get_return_object();
+		_STD suspend_always initial_suspend() const noexcept;
+		FinalAwaiter final_suspend() const noexcept;
+		void return_void() const noexcept;
+		void unhandled_exception() const noexcept;
+
+		WhenAllLatch* _pLatch = nullptr;
+	};
+
+	WhenAllDriver(const WhenAllDriver& src) = delete;
+	WhenAllDriver(WhenAllDriver&& src) noexcept;
+	~WhenAllDriver();
+
+	void start(WhenAllLatch& latch);
+
+private:
+	explicit WhenAllDriver(_STD coroutine_handle<promise_type> handle);
+
+	_STD coroutine_handle<promise_type> _handle;
+};
+
+template<class T>
+WhenAllDriver makeWhenAllDriver(task<T>& t);
+
+// Starts every driver and suspends until they have all finished
+class WhenAllAwaiter {
+public:
+	WhenAllAwaiter(_STD vector<WhenAllDriver>& drivers);
+
+	bool await_ready() const noexcept;
+	bool await_suspend(_STD coroutine_handle<> handle);
+	void await_resume() const noexcept;
+
+private:
+	_STD vector<WhenAllDriver>& _drivers;
+	WhenAllLatch _latch;
+};
+
+template<class T>
+using WhenAllValue = _STD conditional_t<_STD is_void_v<T>, _STD monostate, T>;
+
+template<class T>
+task<_STD conditional_t<_STD is_void_v<T>, void, _STD vector<T>>> when_all(_STD vector<task<T>> tasks);
+
+template<class... Ts>
+task<_STD tuple<WhenAllValue<Ts>...>> when_all(task<Ts>... tasks);
+
+template<class T>
+T syncWait(const ThreadPool& pool, task<T> t);
+
+// PoolScheduleAwaiter
+
+inline PoolScheduleAwaiter::PoolScheduleAwaiter(const ThreadPool& pool)
+	: _pool(pool)
+{
+}
+
+inline bool PoolScheduleAwaiter::await_ready() const noexcept
+{
+	return false;
+}
+
+inline void PoolScheduleAwaiter::await_suspend(_STD coroutine_handle<> handle) const
+{
+	_pool.enqueue([handle]() {
+		handle.resume();
+	});
+}
+
+inline void PoolScheduleAwaiter::await_resume() const noexcept
+{
+}
+
+inline PoolScheduleAwaiter ThreadPool::schedule() const
+{
+	return PoolScheduleAwaiter(*this);
+}
+
+// TaskPromiseBase
+
+inline bool TaskPromiseBase::FinalAwaiter::await_ready() const noexcept
+{
+	return false;
+}
+
+template<class P>
+_STD coroutine_handle<> TaskPromiseBase::FinalAwaiter::await_suspend(_STD coroutine_handle<P> handle) const noexcept
+{
+	auto& promise = handle.promise();
+	if (promise._continuation)
+		return promise._continuation;
+
+	if (promise._pDone) {
+		// The waiter may destroy the frame as soon as the flag is set, hold the flag ourselves
+		auto pDone = promise._pDone;
+		pDone->store(1, _STD memory_order_release);
+		pDone->notify_all();
+	}
+	return _STD noop_coroutine();
+}
+
+inline void TaskPromiseBase::FinalAwaiter::await_resume() const noexcept
+{
+}
+
+inline _STD suspend_always TaskPromiseBase::initial_suspend() const noexcept
+{
+	return {};
+}
+
+inline TaskPromiseBase::FinalAwaiter TaskPromiseBase::final_suspend() const noexcept
+{
+	return {};
+}
+
+inline void TaskPromiseBase::unhandled_exception()
+{
+	_exception = _STD current_exception();
+}
+
+// TaskPromise
+
+template<class T>
+task<T> TaskPromise<T>::get_return_object()
+{
+	return task<T>(_STD coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+template<class T>
+template<class U>
+void TaskPromise<T>::return_value(U&& value)
+{
+	_value.emplace(_STD forward<U>(value));
+}
+
+template<class T>
+T TaskPromise<T>::getResult()
+{
+	if (_exception)
+		_STD rethrow_exception(_exception);
+	return _STD move(*_value);
+}
+
+inline task<void> TaskPromise<void>::get_return_object()
+{
+	return task<void>(_STD coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+inline void TaskPromise<void>::return_void() const noexcept
+{
+}
+
+inline void TaskPromise<void>::getResult()
+{
+	if (_exception)
+		_STD rethrow_exception(_exception);
+}
+
+// task
+
+template<class T>
+task<T>::task(_STD coroutine_handle<promise_type> handle)
+	: _handle(handle)
+{
+}
+
+template<class T>
+task<T>::task(task&& src) noexcept
+	: _handle(src._handle)
+{
+	src._handle = nullptr;
+}
+
+template<class T>
+task<T>::~task()
+{
+	if (_handle)
+		_handle.destroy();
+}
+
+template<class T>
+task<T>& task<T>::operator = (task&& rhs) noexcept
+{
+	if (this != &rhs) {
+		if (_handle)
+			_handle.destroy();
+		_handle = rhs._handle;
+		rhs._handle = nullptr;
+	}
+	return *this;
+}
+
+template<class T>
+inline bool task<T>::valid() const
+{
+	return _handle != nullptr;
+}
+
+template<class T>
+inline bool task<T>::isReady() const
+{
+	return !_handle || _handle.done();
+}
+
+template<class T>
+inline auto task<T>::operator co_await() && noexcept
+{
+	assert(_handle);
+	return Awaiter{ _handle };
+}
+
+template<class T>
+inline auto task<T>::operator co_await() & noexcept
+{
+	assert(_handle);
+	return Awaiter{ _handle };
+}
+
+template<class T>
+inline auto task<T>::whenReady() noexcept
+{
+	assert(_handle);
+	return ReadyAwaiter{ { _handle } };
+}
+
+template<class T>
+T task<T>::getResult()
+{
+	assert(_handle && _handle.done());
+	return _handle.promise().getResult();
+}
+
+template<class T>
+inline bool task<T>::Awaiter::await_ready() const noexcept
+{
+	return _handle.done();
+}
+
+template<class T>
+inline _STD coroutine_handle<> task<T>::Awaiter::await_suspend(_STD coroutine_handle<> awaiting) const noexcept
+{
+	// Start the task on this thread, it resumes us when it finishes
+	_handle.promise()._continuation = awaiting;
+	return _handle;
+}
+
+template<class T>
+inline T task<T>::Awaiter::await_resume() const
+{
+	return _handle.promise().getResult();
+}
+
+template<class T>
+inline void task<T>::ReadyAwaiter::await_resume() const noexcept
+{
+}
+
+// when_all
+
+inline bool WhenAllDriver::promise_type::FinalAwaiter::await_ready() const noexcept
+{
+	return false;
+}
+
+inline _STD coroutine_handle<> WhenAllDriver::promise_type::FinalAwaiter::await_suspend(_STD coroutine_handle<promise_type> handle) const noexcept
+{
+	WhenAllLatch& latch = *handle.promise()._pLatch;
+	if (latch._count.fetch_sub(1, _STD memory_order_acq_rel) == 1)
+		return latch._continuation;
+	return _STD noop_coroutine();
+}
+
+inline void WhenAllDriver::promise_type::FinalAwaiter::await_resume() const noexcept
+{
+}
+
+inline WhenAllDriver WhenAllDriver::promise_type::get_return_object()
+{
+	return WhenAllDriver(_STD coroutine_handle<promise_type>::from_promise(*this));
+}
+
+inline _STD suspend_always WhenAllDriver::promise_type::initial_suspend() const noexcept
+{
+	return {};
+}
+
+inline WhenAllDriver::promise_type::FinalAwaiter WhenAllDriver::promise_type::final_suspend() const noexcept
+{
+	return {};
+}
+
+inline void WhenAllDriver::promise_type::return_void() const noexcept
+{
+}
+
+inline void WhenAllDriver::promise_type::unhandled_exception() const noexcept
+{
+	// whenReady doesn't throw, the task's exception stays in the task
+	assert(!"WhenAllDriver exception");
+}
+
+inline WhenAllDriver::WhenAllDriver(_STD coroutine_handle<promise_type> handle)
+	: _handle(handle)
+{
+}
+
+inline WhenAllDriver::WhenAllDriver(WhenAllDriver&& src) noexcept
+	: _handle(src._handle)
+{
+	src._handle = nullptr;
+}
+
+inline WhenAllDriver::~WhenAllDriver()
+{
+	if (_handle)
+		_handle.destroy();
+}
+
+inline void WhenAllDriver::start(WhenAllLatch& latch)
+{
+	_handle.promise()._pLatch = &latch;
+	_handle.resume();
+}
+
+template<class T>
+WhenAllDriver makeWhenAllDriver(task<T>& t)
+{
+	co_await t.whenReady();
+}
+
+inline WhenAllAwaiter::WhenAllAwaiter(_STD vector<WhenAllDriver>& drivers)
+	: _drivers(drivers)
+{
+}
+
+inline bool WhenAllAwaiter::await_ready() const noexcept
+{
+	return _drivers.empty();
+}
+
+inline bool WhenAllAwaiter::await_suspend(_STD coroutine_handle<> handle)
+{
+	// One count per driver plus ours, so no driver can resume us before all have been started
+	_latch._count.store(_drivers.size() + 1, _STD memory_order_relaxed);
+	_latch._continuation = handle;
+	for (auto& driver : _drivers)
+		driver.start(_latch);
+
+	// Everything finished inline, carry on without suspending
+	return _latch._count.fetch_sub(1, _STD memory_order_acq_rel) != 1;
+}
+
+inline void WhenAllAwaiter::await_resume() const noexcept
+{
+}
+
+template<class T>
+task<_STD conditional_t<_STD is_void_v<T>, void, _STD vector<T>>> when_all(_STD vector<task<T>> tasks)
+{
+	_STD vector<WhenAllDriver> drivers;
+	drivers.reserve(tasks.size());
+	for (auto& t : tasks)
+		drivers.push_back(makeWhenAllDriver(t));
+
+	co_await WhenAllAwaiter(drivers);
+
+	if constexpr (_STD is_void_v<T>) {
+		for (auto& t : tasks)
+			t.getResult();
+	} else {
+		_STD vector<T> results;
+		results.reserve(tasks.size());
+		for (auto& t : tasks)
+			results.push_back(t.getResult());
+		co_return results;
+	}
+}
+
+template<class T>
+WhenAllValue<T> getWhenAllValue(task<T>& t)
+{
+	if constexpr (_STD is_void_v<T>) {
+		t.getResult();
+		return {};
+	} else {
+		return t.getResult();
+	}
+}
+
+template<class... Ts>
+task<_STD tuple<WhenAllValue<Ts>...>> when_all(task<Ts>... tasks)
+{
+	_STD vector<WhenAllDriver> drivers;
+	drivers.reserve(sizeof...(Ts));
+	(drivers.push_back(makeWhenAllDriver(tasks)), ...);
+
+	co_await WhenAllAwaiter(drivers);
+
+	// Braced initialization evaluates left to right, the first exception in argument order wins
+	co_return _STD tuple<WhenAllValue<Ts>...>{ getWhenAllValue(tasks)... };
+}
+
+// syncWait
+
+template<class T>
+T syncWait(const ThreadPool& pool, task<T> t)
+{
+	assert(t._handle);
+
+	auto pDone = _STD make_shared<_STD atomic<uint32_t>>(0);
+	t._handle.promise()._pDone = pDone;
+	t._handle.resume();
+
+	while (!pDone->load(_STD memory_order_acquire)) {
+		if (!pool.runPendingTask())
+			pDone->wait(0, _STD memory_order_acquire);
+	}
+
+	return t.getResult();
+}
+
+}
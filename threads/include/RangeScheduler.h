@@ -0,0 +1,263 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include "defines.h"
+#include <atomic>
+#include <vector>
+#include <CancellationToken.h>
+
+#define RANGE_SCHEDULER_CACHE_LINE 64
+#define RANGE_DEQUE_SIZE 64 // Bisection of a size_t range can't nest deeper than 64
+
+namespace MultiCore
+{
+
+/*
+	Selects how a ThreadPool call divides its index range among the participating threads.
+
+	STRIDED is the original behaviour, participant p runs p, p + n, p + 2n...
+	STATIC gives each participant contiguous blocks of grain size, dealt round robin. Grain size 0 gives one block per
+	participant, numSteps / numParticipants long. No shared state, best when every index costs the same.
+	DYNAMIC hands out blocks of grain size from an atomic counter as participants become free.
+	GUIDED is DYNAMIC with blocks that start at remaining / (2 * numParticipants) and shrink down to the grain size,
+	fewer counter hits than DYNAMIC with a similar tail.
+	STEALING gives each participant a contiguous slice and splits it in halves down to the grain size. The halves
+	go on the participant's deque and idle participants steal the largest pieces from busy ones. Use it when the cost
+	per index varies. Grain size 0 picks numSteps / (8 * numParticipants).
+*/
+
+class Partitioner {
+public:
+	enum Kind {
+		STRIDED,
+		STATIC,
+		DYNAMIC,
+		GUIDED,
+		STEALING,
+	};
+
+	Partitioner() = default;
+
+	static Partitioner strided();
+	static Partitioner staticBlocks(size_t grainSize = 0);
+	static Partitioner dynamic(size_t grainSize = 1);
+	static Partitioner guided(size_t grainSize = 1);
+	static Partitioner stealing(size_t grainSize = 0);
+
+	Kind getKind() const;
+	size_t getGrainSize() const;
+
+private:
+	Partitioner(Kind kind, size_t grainSize);
+
+	Kind _kind = STRIDED;
+	size_t _grainSize = 1;
+};
+
+/*
+	Chase-Lev work stealing deque of index ranges. The owner pushes and pops at the bottom, thieves take from the top.
+	Fixed capacity, the owner only ever holds one bisection chain.
+*/
+
+class RangeDeque {
+public:
+	void push(size_t begin, size_t end);
+	bool pop(size_t& begin, size_t& end);
+	bool steal(size_t& begin, size_t& end);
+
+private:
+	struct Slot {
+		_STD atomic<size_t> _begin = 0, _end = 0;
+	};
+
+	alignas(RANGE_SCHEDULER_CACHE_LINE) _STD atomic<int64_t> _top = 0;
+	alignas(RANGE_SCHEDULER_CACHE_LINE) _STD atomic<int64_t> _bottom = 0;
+	Slot _slots[RANGE_DEQUE_SIZE];
+};
+
+// Observer for runParticipant that does nothing
+struct NullChunkObserver {
+	void chunkBegin(size_t, size_t) {}
+	void chunkEnd() {}
+};
+
+/*
+	Hands out chunks of [0, numSteps) to a fixed number of participants according to a Partitioner.
+	One instance per call, shared by all the participants. Participant numbers run from 0 to numParticipants - 1.
+*/
+
+class RangeScheduler {
+public:
+	// maxParticipants > numParticipants leaves room for helpers to join after the start, see claimHelper
+	RangeScheduler(size_t numSteps, size_t numParticipants, const Partitioner& part, size_t maxParticipants = 0, const CancellationToken* pCancel = nullptr);
+	RangeScheduler(const RangeScheduler& src) = delete;
+
+	RangeScheduler& operator = (const RangeScheduler& rhs) = delete;
+
+	size_t getNumParticipants() const;
+
+	// DYNAMIC, GUIDED and STEALING share their work, a participant that joins late still gets some
+	bool acceptsHelpers() const;
+
+	// Participant number for a late joiner, -1 if the slots are used up or the partitioner can't use one
+	size_t claimHelper();
+
+	// Gets participant's next chunk, indices begin, begin + stride ... < end. Returns false when there is no more work.
+	bool next(size_t participant, size_t& begin, size_t& end, size_t& stride);
+
+	// Stops every participant at its next index. Also set by the CancellationToken, if there is one.
+	void cancel();
+	bool isCancelled() const;
+
+	// The participant's function returned false. Abandons the rest of its current chunk, queued work can still be stolen.
+	void stop(size_t participant);
+
+	// Runs f(index)->bool for all the chunks the participant receives
+	template<class L>
+	void runParticipant(size_t participant, const L& f);
+
+	// Same, calling observer.chunkBegin(begin, end) and observer.chunkEnd() around each chunk
+	template<class L, class O>
+	void runParticipant(size_t participant, const L& f, O& observer);
+
+private:
+	struct alignas(RANGE_SCHEDULER_CACHE_LINE) Participant {
+		RangeDeque _deque;
+		size_t _held = 0; // Number of steps in the chunk being executed
+		size_t _numChunks = 0; // Chunks taken so far, STATIC
+		size_t _begin = 0, _end = 0; // Initial slice
+		bool _started = false;
+		uint64_t _rand = 0;
+	};
+
+	void retire(Participant& p);
+	bool nextStatic(size_t participant, size_t& begin, size_t& end);
+	bool nextDynamic(size_t& begin, size_t& end);
+	bool nextGuided(size_t& begin, size_t& end);
+	bool nextStealing(size_t participant, size_t& begin, size_t& end);
+	bool trySteal(size_t participant, size_t& begin, size_t& end);
+
+	const size_t _numSteps, _numParticipants, _maxParticipants;
+	Partitioner _part;
+	_STD atomic<size_t> _numJoined;
+	size_t _grainSize;
+	alignas(RANGE_SCHEDULER_CACHE_LINE) _STD atomic<size_t> _numRemaining;
+	alignas(RANGE_SCHEDULER_CACHE_LINE) _STD atomic<size_t> _cursor = 0;
+	_STD vector<Participant> _participants;
+	const CancellationToken* _pCancel;
+	alignas(RANGE_SCHEDULER_CACHE_LINE) _STD atomic<bool> _cancelled = false;
+};
+
+inline Partitioner Partitioner::strided()
+{
+	return Partitioner(STRIDED, 1);
+}
+
+inline Partitioner Partitioner::staticBlocks(size_t grainSize)
+{
+	return Partitioner(STATIC, grainSize);
+}
+
+inline Partitioner Partitioner::dynamic(size_t grainSize)
+{
+	return Partitioner(DYNAMIC, grainSize);
+}
+
+inline Partitioner Partitioner::guided(size_t grainSize)
+{
+	return Partitioner(GUIDED, grainSize);
+}
+
+inline Partitioner Partitioner::stealing(size_t grainSize)
+{
+	return Partitioner(STEALING, grainSize);
+}
+
+inline Partitioner::Partitioner(Kind kind, size_t grainSize)
+	: _kind(kind)
+	, _grainSize(grainSize)
+{
+}
+
+inline Partitioner::Kind Partitioner::getKind() const
+{
+	return _kind;
+}
+
+inline size_t Partitioner::getGrainSize() const
+{
+	return _grainSize;
+}
+
+inline size_t RangeScheduler::getNumParticipants() const
+{
+	return _numParticipants;
+}
+
+inline bool RangeScheduler::acceptsHelpers() const
+{
+	switch (_part.getKind()) {
+		case Partitioner::DYNAMIC:
+		case Partitioner::GUIDED:
+		case Partitioner::STEALING:
+			return _maxParticipants > _numParticipants;
+		default:
+			return false;
+	}
+}
+
+inline bool RangeScheduler::isCancelled() const
+{
+	return _cancelled.load(_STD memory_order_relaxed) || (_pCancel && _pCancel->isCancelled());
+}
+
+template<class L>
+void RangeScheduler::runParticipant(size_t participant, const L& f)
+{
+	NullChunkObserver observer;
+	runParticipant(participant, f, observer);
+}
+
+template<class L, class O>
+void RangeScheduler::runParticipant(size_t participant, const L& f, O& observer)
+{
+	size_t begin, end, stride;
+	while (next(participant, begin, end, stride)) {
+		observer.chunkBegin(begin, end);
+		for (size_t i = begin; i < end; i += stride) {
+			if (isCancelled() || !f(i)) {
+				observer.chunkEnd();
+				stop(participant);
+				return;
+			}
+		}
+		observer.chunkEnd();
+	}
+}
+
+}
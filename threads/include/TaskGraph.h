@@ -0,0 +1,99 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <MultiCoreUtil.h>
+
+namespace MultiCore
+{
+
+/*
+	Dependency graph of tasks run on a ThreadPool's threads.
+
+	A node runs as soon as all of its predecessors have finished, there are no barriers between stages. Nodes added
+	before run() wait for it. Nodes added while the graph is running, typically from inside another node's task, are
+	scheduled at once, so a task can add its own successors. addNode with a predecessor that has already finished
+	treats that edge as satisfied.
+
+	wait() runs queued pool tasks on the calling thread until every node has finished. Nodes not yet released by run()
+	are released first, so wait() without run() is the same as runAndWait(). If a task throws, the nodes that haven't
+	started yet are skipped and wait() rethrows the first exception once the rest have finished. The destructor waits
+	for a running graph too, but drops the exception.
+*/
+
+class TaskGraph {
+public:
+	using NodeId = size_t;
+	using TaskType = ThreadPool::TaskType;
+
+	TaskGraph(const ThreadPool& pool);
+	TaskGraph(const TaskGraph& src) = delete;
+	~TaskGraph();
+
+	TaskGraph& operator = (const TaskGraph& rhs) = delete;
+
+	NodeId addNode(TaskType task, const _STD vector<NodeId>& predecessors = {});
+
+	// 'to' runs after 'from'. Only for nodes that haven't been released by run() yet.
+	void addEdge(NodeId from, NodeId to);
+
+	void run();
+	void wait();
+	void runAndWait();
+
+	size_t size() const;
+	bool isDone(NodeId id) const;
+
+private:
+	struct Node {
+		TaskType _task;
+		_STD atomic<size_t> _numPending = 1; // Unfinished predecessors plus one until the node is released
+		_STD vector<NodeId> _successors;
+		bool _done = false;
+	};
+
+	void waitForNodes();
+	void release(NodeId id);
+	void execute(NodeId id);
+
+	const ThreadPool& _pool;
+	mutable _STD mutex _mutex;
+	_STD deque<Node> _nodes; // deque, nodes don't move as the graph grows
+	_STD vector<NodeId> _unreleased;
+	bool _running = false;
+	_STD atomic<size_t> _numUnfinished = 0;
+	_STD atomic<bool> _failed = false;
+	_STD exception_ptr _exception; // guarded by _mutex
+};
+
+}
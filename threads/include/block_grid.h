@@ -0,0 +1,125 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <memory>
+#include <vector>
+#include <local_heap.h>
+#include <MultiCoreUtil.h>
+
+namespace MultiCore
+{
+
+/*
+	3D cell grid split into fixed size cubic blocks, matching DFHM's model of one thread per block and one heap per block.
+
+	Each block owns a local_heap and a dense array of (blockSize + 2 * haloWidth)^3 cells allocated from it. Local
+	coordinates run from -haloWidth to blockSize + haloWidth - 1, negative and past the end being the halo. Cells are
+	stored x fastest, so a neighbour is ptr +/- stride(axis), no lookups.
+
+	runBlocks hands whole blocks to ThreadPool workers with the block's heap set as the thread heap, so any MultiCore
+	container created inside the callback lives in that block's heap.
+
+	Halos are NOT kept in sync on write. exchangeHalos is an explicit parallel step: every block copies its halo from
+	the neighbours' interiors. Each block only writes its own halo, so this is race free as long as nothing writes
+	interiors at the same time. Halo cells outside the domain are left as they are.
+*/
+
+template<class T>
+class block_grid {
+public:
+	class Block {
+	public:
+		Block(size_t blockIdx, const size_t origin[3], size_t blockSize, size_t haloWidth);
+		Block(const Block& src) = delete;
+		~Block();
+
+		Block& operator = (const Block& rhs) = delete;
+
+		size_t getIndex() const;
+		size_t getOrigin(int axis) const;
+		size_t getBlockSize() const;
+		size_t getHaloWidth() const;
+
+		// Local coordinates, -haloWidth <= i < blockSize + haloWidth
+		const T& operator()(int i, int j, int k) const;
+		T& operator()(int i, int j, int k);
+		const T* ptr(int i, int j, int k) const;
+		T* ptr(int i, int j, int k);
+		ptrdiff_t stride(int axis) const;
+
+		local_heap& getHeap();
+
+	private:
+		size_t cellIndex(int i, int j, int k) const;
+
+		const size_t _blockIdx;
+		size_t _origin[3];
+		const size_t _blockSize, _haloWidth, _paddedSize;
+		local_heap _heap;
+		T* _pCells = nullptr;
+	};
+
+	block_grid(size_t numCellsX, size_t numCellsY, size_t numCellsZ, size_t blockSize = 8, size_t haloWidth = 1);
+	block_grid(const block_grid& src) = delete;
+
+	block_grid& operator = (const block_grid& rhs) = delete;
+
+	size_t getNumCells(int axis) const;
+	size_t getNumBlocks(int axis) const;
+	size_t getNumBlocks() const;
+	size_t getBlockSize() const;
+	size_t getHaloWidth() const;
+
+	size_t blockIndex(size_t bi, size_t bj, size_t bk) const;
+	const Block& getBlock(size_t blockIdx) const;
+	Block& getBlock(size_t blockIdx);
+
+	// Global cell coordinates, always the owning block's interior cell
+	const T& operator()(size_t i, size_t j, size_t k) const;
+	T& operator()(size_t i, size_t j, size_t k);
+
+	// Calls f(Block& blk) for every block, one block per task, with the block's heap as the thread heap.
+	// Return false from f to stop the calling thread's remaining blocks, the same as ThreadPool::run.
+	template<class L>
+	void runBlocks(const ThreadPool& pool, L f, bool multiCore);
+
+	void exchangeHalos(const ThreadPool& pool, bool multiCore);
+
+private:
+	void pullHalo(Block& blk) const;
+	bool findOwner(const Block& blk, int i, int j, int k, const T*& pSrc) const;
+
+	size_t _numCells[3];
+	size_t _numBlocks[3];
+	const size_t _blockSize, _haloWidth;
+	_STD vector<_STD unique_ptr<Block>> _blocks;
+};
+
+}
+
+#include <block_grid.hpp>
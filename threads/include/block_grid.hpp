@@ -0,0 +1,298 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <assert.h>
+#include <block_grid.h>
+
+#define TEMPL_DECL template<class T> 
+#define GRID_DECL block_grid<T> 
+#define BLOCK_DECL block_grid<T>::Block
+
+namespace MultiCore {
+
+TEMPL_DECL
+BLOCK_DECL::Block(size_t blockIdx, const size_t origin[3], size_t blockSize, size_t haloWidth)
+	: _blockIdx(blockIdx)
+	, _blockSize(blockSize)
+	, _haloWidth(haloWidth)
+	, _paddedSize(blockSize + 2 * haloWidth)
+	// A local_heap block is numInitialChunks * (32 + 16)^2 bytes at the default chunk size, make the first one hold
+	// the cells with room to spare
+	, _heap(1 + _paddedSize * _paddedSize * _paddedSize * sizeof(T) / (48 * 48))
+{
+	for (int axis = 0; axis < 3; axis++)
+		_origin[axis] = origin[axis];
+	_pCells = _heap.alloc<T>(_paddedSize * _paddedSize * _paddedSize);
+}
+
+TEMPL_DECL
+BLOCK_DECL::~Block()
+{
+	_heap.free(_pCells);
+}
+
+TEMPL_DECL
+inline size_t BLOCK_DECL::getIndex() const
+{
+	return _blockIdx;
+}
+
+TEMPL_DECL
+inline size_t BLOCK_DECL::getOrigin(int axis) const
+{
+	return _origin[axis];
+}
+
+TEMPL_DECL
+inline size_t BLOCK_DECL::getBlockSize() const
+{
+	return _blockSize;
+}
+
+TEMPL_DECL
+inline size_t BLOCK_DECL::getHaloWidth() const
+{
+	return _haloWidth;
+}
+
+TEMPL_DECL
+inline size_t BLOCK_DECL::cellIndex(int i, int j, int k) const
+{
+	const int h = (int)_haloWidth;
+	assert(i >= -h && j >= -h && k >= -h);
+	assert(i < (int)(_blockSize + _haloWidth) && j < (int)(_blockSize + _haloWidth) && k < (int)(_blockSize + _haloWidth));
+	return ((size_t)(k + h) * _paddedSize + (size_t)(j + h)) * _paddedSize + (size_t)(i + h);
+}
+
+TEMPL_DECL
+inline const T& BLOCK_DECL::operator()(int i, int j, int k) const
+{
+	return _pCells[cellIndex(i, j, k)];
+}
+
+TEMPL_DECL
+inline T& BLOCK_DECL::operator()(int i, int j, int k)
+{
+	return _pCells[cellIndex(i, j, k)];
+}
+
+TEMPL_DECL
+inline const T* BLOCK_DECL::ptr(int i, int j, int k) const
+{
+	return _pCells + cellIndex(i, j, k);
+}
+
+TEMPL_DECL
+inline T* BLOCK_DECL::ptr(int i, int j, int k)
+{
+	return _pCells + cellIndex(i, j, k);
+}
+
+TEMPL_DECL
+inline ptrdiff_t BLOCK_DECL::stride(int axis) const
+{
+	switch (axis) {
+		default:
+		case 0:
+			return 1;
+		case 1:
+			return (ptrdiff_t)_paddedSize;
+		case 2:
+			return (ptrdiff_t)(_paddedSize * _paddedSize);
+	}
+}
+
+TEMPL_DECL
+inline local_heap& BLOCK_DECL::getHeap()
+{
+	return _heap;
+}
+
+/*************************************************************************************************/
+/*************************************************************************************************/
+/*************************************************************************************************/
+
+TEMPL_DECL
+GRID_DECL::block_grid(size_t numCellsX, size_t numCellsY, size_t numCellsZ, size_t blockSize, size_t haloWidth)
+	: _blockSize(blockSize > 0 ? blockSize : 1)
+	, _haloWidth(haloWidth)
+{
+	_numCells[0] = numCellsX;
+	_numCells[1] = numCellsY;
+	_numCells[2] = numCellsZ;
+	for (int axis = 0; axis < 3; axis++)
+		_numBlocks[axis] = (_numCells[axis] + _blockSize - 1) / _blockSize;
+
+	_blocks.resize(getNumBlocks());
+	for (size_t bk = 0; bk < _numBlocks[2]; bk++) {
+		for (size_t bj = 0; bj < _numBlocks[1]; bj++) {
+			for (size_t bi = 0; bi < _numBlocks[0]; bi++) {
+				size_t origin[] = { bi * _blockSize, bj * _blockSize, bk * _blockSize };
+				size_t idx = blockIndex(bi, bj, bk);
+				_blocks[idx] = _STD make_unique<Block>(idx, origin, _blockSize, _haloWidth);
+			}
+		}
+	}
+}
+
+TEMPL_DECL
+inline size_t GRID_DECL::getNumCells(int axis) const
+{
+	return _numCells[axis];
+}
+
+TEMPL_DECL
+inline size_t GRID_DECL::getNumBlocks(int axis) const
+{
+	return _numBlocks[axis];
+}
+
+TEMPL_DECL
+inline size_t GRID_DECL::getNumBlocks() const
+{
+	return _numBlocks[0] * _numBlocks[1] * _numBlocks[2];
+}
+
+TEMPL_DECL
+inline size_t GRID_DECL::getBlockSize() const
+{
+	return _blockSize;
+}
+
+TEMPL_DECL
+inline size_t GRID_DECL::getHaloWidth() const
+{
+	return _haloWidth;
+}
+
+TEMPL_DECL
+inline size_t GRID_DECL::blockIndex(size_t bi, size_t bj, size_t bk) const
+{
+	return (bk * _numBlocks[1] + bj) * _numBlocks[0] + bi;
+}
+
+TEMPL_DECL
+inline const typename GRID_DECL::Block& GRID_DECL::getBlock(size_t blockIdx) const
+{
+	return *_blocks[blockIdx];
+}
+
+TEMPL_DECL
+inline typename GRID_DECL::Block& GRID_DECL::getBlock(size_t blockIdx)
+{
+	return *_blocks[blockIdx];
+}
+
+TEMPL_DECL
+inline const T& GRID_DECL::operator()(size_t i, size_t j, size_t k) const
+{
+	const Block& blk = *_blocks[blockIndex(i / _blockSize, j / _blockSize, k / _blockSize)];
+	return blk((int)(i % _blockSize), (int)(j % _blockSize), (int)(k % _blockSize));
+}
+
+TEMPL_DECL
+inline T& GRID_DECL::operator()(size_t i, size_t j, size_t k)
+{
+	Block& blk = *_blocks[blockIndex(i / _blockSize, j / _blockSize, k / _blockSize)];
+	return blk((int)(i % _blockSize), (int)(j % _blockSize), (int)(k % _blockSize));
+}
+
+TEMPL_DECL
+template<class L>
+void GRID_DECL::runBlocks(const ThreadPool& pool, L f, bool multiCore)
+{
+	pool.run(_blocks.size(), [this, &f](size_t threadNum, size_t blockIdx)->bool {
+		Block& blk = *_blocks[blockIdx];
+		scoped_set_local_heap heapScope(&blk.getHeap());
+		return f(blk);
+	}, multiCore);
+}
+
+TEMPL_DECL
+void GRID_DECL::exchangeHalos(const ThreadPool& pool, bool multiCore)
+{
+	if (_haloWidth == 0)
+		return;
+
+	pool.run(_blocks.size(), [this](size_t threadNum, size_t blockIdx)->bool {
+		pullHalo(*_blocks[blockIdx]);
+		return true;
+	}, multiCore);
+}
+
+TEMPL_DECL
+bool GRID_DECL::findOwner(const Block& blk, int i, int j, int k, const T*& pSrc) const
+{
+	int64_t g[] = {
+		(int64_t)blk.getOrigin(0) + i,
+		(int64_t)blk.getOrigin(1) + j,
+		(int64_t)blk.getOrigin(2) + k,
+	};
+	for (int axis = 0; axis < 3; axis++) {
+		if (g[axis] < 0 || g[axis] >= (int64_t)_numCells[axis])
+			return false;
+	}
+
+	pSrc = &operator()((size_t)g[0], (size_t)g[1], (size_t)g[2]);
+	return true;
+}
+
+TEMPL_DECL
+void GRID_DECL::pullHalo(Block& blk) const
+{
+	const int h = (int)_haloWidth;
+	const int bs = (int)_blockSize;
+	const T* pSrc;
+
+	for (int k = -h; k < bs + h; k++) {
+		for (int j = -h; j < bs + h; j++) {
+			if (k >= 0 && k < bs && j >= 0 && j < bs) {
+				// Interior row, only the two ends are halo
+				for (int i = -h; i < 0; i++) {
+					if (findOwner(blk, i, j, k, pSrc))
+						blk(i, j, k) = *pSrc;
+				}
+				for (int i = bs; i < bs + h; i++) {
+					if (findOwner(blk, i, j, k, pSrc))
+						blk(i, j, k) = *pSrc;
+				}
+			} else {
+				for (int i = -h; i < bs + h; i++) {
+					if (findOwner(blk, i, j, k, pSrc))
+						blk(i, j, k) = *pSrc;
+				}
+			}
+		}
+	}
+}
+
+}
+
+#undef TEMPL_DECL
+#undef GRID_DECL
+#undef BLOCK_DECL
@@ -0,0 +1,129 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <local_heap.h>
+
+#define CUM_DEFAULT_STRIPES 64
+#define CUM_DEFAULT_BUCKETS 16
+#define CUM_CACHE_LINE 64
+
+namespace MultiCore
+{
+
+/*
+	Hash map for lookup tables shared by all workers, e.g. vertex or face registries used while stitching blocks.
+
+	The table is split into stripes using the high bits of the hash. Each stripe is a complete chained hash table with its
+	own shared_mutex, bucket array and local_heap, padded to its own cache line. Nodes never move between stripes, so a
+	stripe rehashes under its own lock and there is no global lock anywhere.
+
+	Readers take the stripe lock shared, writers take it exclusive. Lookups return copies because a reference could be
+	invalidated by a concurrent erase. Use update() to modify an entry in place.
+*/
+
+template<class KEY, class T, class HASH = _STD hash<KEY>>
+class concurrent_unordered_map {
+public:
+	concurrent_unordered_map(size_t numStripes = CUM_DEFAULT_STRIPES, size_t numBucketsPerStripe = CUM_DEFAULT_BUCKETS, const HASH& hasher = HASH());
+	concurrent_unordered_map(const concurrent_unordered_map& src) = delete;
+	~concurrent_unordered_map();
+
+	concurrent_unordered_map& operator = (const concurrent_unordered_map& rhs) = delete;
+
+	// All of these are thread safe
+	bool insert(const KEY& key, const T& val);
+	bool insert_or_assign(const KEY& key, const T& val);
+	bool erase(const KEY& key);
+
+	bool find(const KEY& key, T& result) const;
+	bool contains(const KEY& key) const;
+	size_t count(const KEY& key) const;
+
+	// Calls f(T& val) under the stripe's exclusive lock. Returns false if the key is not present.
+	template<class L>
+	bool update(const KEY& key, L f);
+
+	// Inserts initVal if the key is not present, then calls f(T& val) under the stripe's exclusive lock.
+	// Returns true if the entry was inserted.
+	template<class L>
+	bool insert_or_update(const KEY& key, const T& initVal, L f);
+
+	// Calls f(const KEY& key, const T& val) for every entry, locking one stripe at a time.
+	template<class L>
+	void for_each(L f) const;
+
+	size_t size() const;
+	bool empty() const;
+	void clear();
+
+	size_t getNumStripes() const;
+
+private:
+	struct Node {
+		KEY _key;
+		T _val;
+		size_t _hash; // Mixed hash, rehash doesn't call the hasher again
+		Node* _pNext = nullptr;
+	};
+
+	struct alignas(CUM_CACHE_LINE) Stripe {
+		Stripe();
+		~Stripe();
+
+		Node* find(const KEY& key, size_t hash) const;
+		Node* addNode(const KEY& key, const T& val, size_t hash);
+		bool removeNode(const KEY& key, size_t hash);
+		void rehash(size_t newNumBuckets);
+		void clear();
+		size_t bucketIndex(size_t hash) const;
+
+		mutable _STD shared_mutex _mutex;
+		local_heap _heap;
+		Node** _pBuckets = nullptr;
+		size_t _numBuckets = 0;
+		size_t _bucketShift = 64;
+		size_t _stripeBits = 0; // The top bits of the hash picked the stripe, the bucket comes from the bits below them
+		size_t _size = 0;
+	};
+
+	static size_t mixHash(size_t hash);
+	size_t hashOf(const KEY& key) const;
+	Stripe& getStripe(size_t hash) const;
+
+	HASH _hasher;
+	size_t _stripeShift;
+	size_t _numStripes;
+	Stripe* _pStripes;
+};
+
+}
+
+#include <concurrent_unordered_map.hpp>
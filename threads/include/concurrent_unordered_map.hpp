@@ -0,0 +1,343 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <assert.h>
+#include <bit>
+#include <concurrent_unordered_map.h>
+
+#define TEMPL_DECL template<class KEY, class T, class HASH>
+#define MAP_DECL concurrent_unordered_map<KEY, T, HASH>
+
+namespace MultiCore {
+
+TEMPL_DECL
+MAP_DECL::concurrent_unordered_map(size_t numStripes, size_t numBucketsPerStripe, const HASH& hasher)
+	: _hasher(hasher)
+{
+	// Both counts must be powers of 2 so the hash can be split with shifts and masks
+	_numStripes = _STD bit_ceil(numStripes < 1 ? (size_t)1 : numStripes);
+	_stripeShift = 64 - (size_t)_STD countr_zero(_numStripes);
+	_pStripes = new Stripe[_numStripes];
+
+	size_t numBuckets = _STD bit_ceil(numBucketsPerStripe < 1 ? (size_t)1 : numBucketsPerStripe);
+	for (size_t i = 0; i < _numStripes; i++) {
+		_pStripes[i]._stripeBits = 64 - _stripeShift;
+		_pStripes[i].rehash(numBuckets);
+	}
+}
+
+TEMPL_DECL
+MAP_DECL::~concurrent_unordered_map()
+{
+	delete[] _pStripes;
+}
+
+TEMPL_DECL
+inline size_t MAP_DECL::mixHash(size_t hash)
+{
+	// std::hash is the identity for integers on some platforms. Fibonacci hashing spreads the bits into the high end,
+	// the top bits pick the stripe and the bits just below them the bucket. The low bits are the weakest, keys that
+	// are multiples of 2^k would share few of them.
+	return (size_t)((uint64_t)hash * 0x9E3779B97F4A7C15ull);
+}
+
+TEMPL_DECL
+inline size_t MAP_DECL::hashOf(const KEY& key) const
+{
+	return mixHash(_hasher(key));
+}
+
+TEMPL_DECL
+inline typename MAP_DECL::Stripe& MAP_DECL::getStripe(size_t hash) const
+{
+	return _pStripes[_numStripes == 1 ? 0 : (hash >> _stripeShift)];
+}
+
+TEMPL_DECL
+bool MAP_DECL::insert(const KEY& key, const T& val)
+{
+	size_t hash = hashOf(key);
+	Stripe& stripe = getStripe(hash);
+	_STD unique_lock lk(stripe._mutex);
+	if (stripe.find(key, hash))
+		return false;
+	stripe.addNode(key, val, hash);
+	return true;
+}
+
+TEMPL_DECL
+bool MAP_DECL::insert_or_assign(const KEY& key, const T& val)
+{
+	size_t hash = hashOf(key);
+	Stripe& stripe = getStripe(hash);
+	_STD unique_lock lk(stripe._mutex);
+	Node* pNode = stripe.find(key, hash);
+	if (pNode) {
+		pNode->_val = val;
+		return false;
+	}
+	stripe.addNode(key, val, hash);
+	return true;
+}
+
+TEMPL_DECL
+bool MAP_DECL::erase(const KEY& key)
+{
+	size_t hash = hashOf(key);
+	Stripe& stripe = getStripe(hash);
+	_STD unique_lock lk(stripe._mutex);
+	return stripe.removeNode(key, hash);
+}
+
+TEMPL_DECL
+bool MAP_DECL::find(const KEY& key, T& result) const
+{
+	size_t hash = hashOf(key);
+	Stripe& stripe = getStripe(hash);
+	_STD shared_lock lk(stripe._mutex);
+	const Node* pNode = stripe.find(key, hash);
+	if (pNode) {
+		result = pNode->_val;
+		return true;
+	}
+	return false;
+}
+
+TEMPL_DECL
+bool MAP_DECL::contains(const KEY& key) const
+{
+	size_t hash = hashOf(key);
+	Stripe& stripe = getStripe(hash);
+	_STD shared_lock lk(stripe._mutex);
+	return stripe.find(key, hash) != nullptr;
+}
+
+TEMPL_DECL
+inline size_t MAP_DECL::count(const KEY& key) const
+{
+	return contains(key) ? 1 : 0;
+}
+
+TEMPL_DECL
+template<class L>
+bool MAP_DECL::update(const KEY& key, L f)
+{
+	size_t hash = hashOf(key);
+	Stripe& stripe = getStripe(hash);
+	_STD unique_lock lk(stripe._mutex);
+	Node* pNode = stripe.find(key, hash);
+	if (!pNode)
+		return false;
+	f(pNode->_val);
+	return true;
+}
+
+TEMPL_DECL
+template<class L>
+bool MAP_DECL::insert_or_update(const KEY& key, const T& initVal, L f)
+{
+	size_t hash = hashOf(key);
+	Stripe& stripe = getStripe(hash);
+	_STD unique_lock lk(stripe._mutex);
+	bool inserted = false;
+	Node* pNode = stripe.find(key, hash);
+	if (!pNode) {
+		pNode = stripe.addNode(key, initVal, hash);
+		inserted = true;
+	}
+	f(pNode->_val);
+	return inserted;
+}
+
+TEMPL_DECL
+template<class L>
+void MAP_DECL::for_each(L f) const
+{
+	for (size_t i = 0; i < _numStripes; i++) {
+		const Stripe& stripe = _pStripes[i];
+		_STD shared_lock lk(stripe._mutex);
+		for (size_t j = 0; j < stripe._numBuckets; j++) {
+			for (const Node* pNode = stripe._pBuckets[j]; pNode; pNode = pNode->_pNext)
+				f(pNode->_key, pNode->_val);
+		}
+	}
+}
+
+TEMPL_DECL
+size_t MAP_DECL::size() const
+{
+	size_t result = 0;
+	for (size_t i = 0; i < _numStripes; i++) {
+		_STD shared_lock lk(_pStripes[i]._mutex);
+		result += _pStripes[i]._size;
+	}
+	return result;
+}
+
+TEMPL_DECL
+inline bool MAP_DECL::empty() const
+{
+	return size() == 0;
+}
+
+TEMPL_DECL
+void MAP_DECL::clear()
+{
+	for (size_t i = 0; i < _numStripes; i++) {
+		_STD unique_lock lk(_pStripes[i]._mutex);
+		_pStripes[i].clear();
+	}
+}
+
+TEMPL_DECL
+inline size_t MAP_DECL::getNumStripes() const
+{
+	return _numStripes;
+}
+
+/*************************************************************************************************/
+/*************************************************************************************************/
+/*************************************************************************************************/
+
+TEMPL_DECL
+MAP_DECL::Stripe::Stripe()
+	: _heap(256, sizeof(Node))
+{
+}
+
+TEMPL_DECL
+MAP_DECL::Stripe::~Stripe()
+{
+	clear();
+	_heap.free(_pBuckets);
+}
+
+TEMPL_DECL
+inline typename MAP_DECL::Node* MAP_DECL::Stripe::find(const KEY& key, size_t hash) const
+{
+	for (Node* pNode = _pBuckets[bucketIndex(hash)]; pNode; pNode = pNode->_pNext) {
+		if (pNode->_hash == hash && pNode->_key == key)
+			return pNode;
+	}
+	return nullptr;
+}
+
+TEMPL_DECL
+typename MAP_DECL::Node* MAP_DECL::Stripe::addNode(const KEY& key, const T& val, size_t hash)
+{
+	// Caller holds the exclusive lock
+	if (_size + 1 > _numBuckets)
+		rehash(2 * _numBuckets);
+
+	Node* pNode = _heap.alloc<Node>(1);
+	pNode->_key = key;
+	pNode->_val = val;
+	pNode->_hash = hash;
+
+	Node*& pHead = _pBuckets[bucketIndex(hash)];
+	pNode->_pNext = pHead;
+	pHead = pNode;
+	_size++;
+
+	return pNode;
+}
+
+TEMPL_DECL
+bool MAP_DECL::Stripe::removeNode(const KEY& key, size_t hash)
+{
+	// Caller holds the exclusive lock
+	Node** ppNode = &_pBuckets[bucketIndex(hash)];
+	while (*ppNode) {
+		Node* pNode = *ppNode;
+		if (pNode->_key == key) {
+			*ppNode = pNode->_pNext;
+			_heap.free(pNode);
+			_size--;
+			return true;
+		}
+		ppNode = &pNode->_pNext;
+	}
+	return false;
+}
+
+TEMPL_DECL
+void MAP_DECL::Stripe::rehash(size_t newNumBuckets)
+{
+	// Caller holds the exclusive lock, or is the constructor
+	Node** pNewBuckets = _heap.alloc<Node*>(newNumBuckets);
+	for (size_t i = 0; i < newNumBuckets; i++)
+		pNewBuckets[i] = nullptr;
+
+	size_t oldNumBuckets = _numBuckets;
+	Node** pOldBuckets = _pBuckets;
+	_numBuckets = newNumBuckets;
+	_bucketShift = 64 - (size_t)_STD countr_zero(newNumBuckets);
+	_pBuckets = pNewBuckets;
+
+	for (size_t i = 0; i < oldNumBuckets; i++) {
+		Node* pNode = pOldBuckets[i];
+		while (pNode) {
+			Node* pNext = pNode->_pNext;
+			Node*& pHead = _pBuckets[bucketIndex(pNode->_hash)];
+			pNode->_pNext = pHead;
+			pHead = pNode;
+			pNode = pNext;
+		}
+	}
+
+	_heap.free(pOldBuckets);
+}
+
+TEMPL_DECL
+inline size_t MAP_DECL::Stripe::bucketIndex(size_t hash) const
+{
+	// A shift by 64 is undefined, one bucket or all the bits used by stripes leave nothing to pick with
+	if (_bucketShift >= 64 || _stripeBits >= 64)
+		return 0;
+	return (hash << _stripeBits) >> _bucketShift;
+}
+
+TEMPL_DECL
+void MAP_DECL::Stripe::clear()
+{
+	for (size_t i = 0; i < _numBuckets; i++) {
+		Node* pNode = _pBuckets[i];
+		while (pNode) {
+			Node* pNext = pNode->_pNext;
+			_heap.free(pNode);
+			pNode = pNext;
+		}
+		_pBuckets[i] = nullptr;
+	}
+	_size = 0;
+}
+
+}
+
+#undef TEMPL_DECL
+#undef MAP_DECL
@@ -0,0 +1,149 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <local_heap.h>
+
+#define CV_FIRST_SEGMENT_SIZE 8
+#define CV_NUM_SEGMENTS 48
+
+namespace MultiCore
+{
+
+/*
+	A vector which can be appended to from many threads at once.
+
+	Storage is a table of segments. Segment 0 holds CV_FIRST_SEGMENT_SIZE entries and each following segment is twice the size
+	of the one before it. Segments are never moved or reallocated, so references and pointers to entries stay valid until
+	clear() or destruction.
+
+	push_back and grow_by claim their indices with a single atomic add. The only lock is taken when a new segment has to be
+	allocated, which happens log2(n) times over the life of the vector. That lock only serializes this vector's own calls
+	into its heap. local_heap is not thread safe, so nothing else may allocate from or free to that heap while the vector
+	can grow. The default is the creating thread's heap, if that thread keeps allocating during the run pass a heap of
+	the vector's own instead.
+
+	Entries are constructed by the thread which claimed them. Reading an entry written by another thread is only safe after
+	that thread has been joined, e.g. after ThreadPool::run returns.
+*/
+
+template<class T>
+class concurrent_vector {
+protected:
+
+	template <bool IsConst>
+	class _iterator
+	{
+	public:
+		friend class MultiCore::concurrent_vector<T>;
+
+		using iterator_category = std::random_access_iterator_tag;
+		using difference_type = std::ptrdiff_t;
+		using value_type = std::remove_cv_t<T>;
+		using source = std::conditional_t<IsConst, const MultiCore::concurrent_vector<T>, MultiCore::concurrent_vector<T>>;
+		using pointer = std::conditional_t<IsConst, T const*, T*>;
+		using reference = std::conditional_t<IsConst, T const&, T&>;
+
+		_iterator() = default;
+		_iterator(source* pSource, size_t idx);
+		_iterator(const _iterator& src) = default;
+
+		bool operator == (const _iterator& rhs) const;
+		bool operator != (const _iterator& rhs) const;
+		bool operator < (const _iterator& rhs) const;
+
+		_iterator& operator ++ ();
+		_iterator& operator --();
+		_iterator operator ++ (int);
+		_iterator operator --(int);
+
+		_iterator operator + (size_t val) const;
+		_iterator operator - (size_t val) const;
+		size_t operator - (const _iterator& rhs) const;
+
+		reference operator *() const;
+		pointer operator->() const;
+
+	private:
+		source* _pSource = nullptr;
+		size_t _idx = 0;
+	};
+
+public:
+	using iterator = _iterator<false>;
+	using const_iterator = _iterator<true>;
+
+	// pHeap, or the calling thread's heap, must not be used by anything else while the vector grows, see above
+	concurrent_vector(local_heap* pHeap = nullptr);
+	concurrent_vector(const concurrent_vector& src) = delete;
+	~concurrent_vector();
+
+	concurrent_vector& operator = (const concurrent_vector& rhs) = delete;
+
+	operator std::vector<T>() const;
+
+	// Thread safe
+	size_t push_back(const T& val);
+	size_t grow_by(size_t num);
+	size_t grow_by(size_t num, const T& val);
+	void reserve(size_t val);
+
+	size_t size() const;
+	bool empty() const;
+	size_t capacity() const;
+
+	const T& operator[](size_t idx) const;
+	T& operator[](size_t idx);
+
+	// NOT thread safe
+	void clear();
+
+	const_iterator begin() const noexcept;
+	iterator begin() noexcept;
+	const_iterator end() const noexcept;
+	iterator end() noexcept;
+
+private:
+	static size_t segmentIndex(size_t idx);
+	static size_t segmentStart(size_t segIdx);
+	static size_t segmentSize(size_t segIdx);
+
+	T* getSegment(size_t segIdx);
+	void ensureSegments(size_t startIdx, size_t endIdx);
+
+	local_heap* _pHeap;
+	_STD mutex _segmentMutex;
+	_STD atomic<size_t> _size = 0;
+	_STD atomic<T*> _segments[CV_NUM_SEGMENTS];
+};
+
+}
+
+#include <concurrent_vector.hpp>
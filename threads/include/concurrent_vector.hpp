@@ -0,0 +1,332 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <assert.h>
+#include <bit>
+#include <concurrent_vector.h>
+
+#define TEMPL_DECL template<class T> 
+#define ITER_TEMPL_DECL template <bool IsConst>
+#define CVECTOR_DECL concurrent_vector<T> 
+#define ITER_DECL concurrent_vector<T>::_iterator<IsConst>
+#define ITER_DECL_2 concurrent_vector<T>::template _iterator<IsConst>
+
+namespace MultiCore {
+
+TEMPL_DECL
+CVECTOR_DECL::concurrent_vector(local_heap* pHeap)
+	: _pHeap(pHeap ? pHeap : local_heap::getThreadHeapPtr())
+{
+	for (size_t i = 0; i < CV_NUM_SEGMENTS; i++)
+		_segments[i].store(nullptr, _STD memory_order_relaxed);
+}
+
+TEMPL_DECL
+CVECTOR_DECL::~concurrent_vector()
+{
+	clear();
+}
+
+TEMPL_DECL
+CVECTOR_DECL::operator std::vector<T>() const
+{
+	std::vector<T> result;
+	result.reserve(size());
+	for (size_t i = 0; i < size(); i++)
+		result.push_back(operator[](i));
+	return result;
+}
+
+TEMPL_DECL
+inline size_t CVECTOR_DECL::segmentIndex(size_t idx)
+{
+	return (size_t)_STD bit_width(idx / CV_FIRST_SEGMENT_SIZE + 1) - 1;
+}
+
+TEMPL_DECL
+inline size_t CVECTOR_DECL::segmentStart(size_t segIdx)
+{
+	return CV_FIRST_SEGMENT_SIZE * (((size_t)1 << segIdx) - 1);
+}
+
+TEMPL_DECL
+inline size_t CVECTOR_DECL::segmentSize(size_t segIdx)
+{
+	return (size_t)CV_FIRST_SEGMENT_SIZE << segIdx;
+}
+
+TEMPL_DECL
+T* CVECTOR_DECL::getSegment(size_t segIdx)
+{
+	assert(segIdx < CV_NUM_SEGMENTS);
+	T* pSeg = _segments[segIdx].load(_STD memory_order_acquire);
+	if (!pSeg) {
+		// Slow path, taken once per segment. Whoever gets the lock first allocates, the others find it done.
+		_STD lock_guard lg(_segmentMutex);
+		pSeg = _segments[segIdx].load(_STD memory_order_relaxed);
+		if (!pSeg) {
+			pSeg = _pHeap->alloc<T>(segmentSize(segIdx));
+			_segments[segIdx].store(pSeg, _STD memory_order_release);
+		}
+	}
+	return pSeg;
+}
+
+TEMPL_DECL
+void CVECTOR_DECL::ensureSegments(size_t startIdx, size_t endIdx)
+{
+	if (startIdx >= endIdx)
+		return;
+	size_t lastSeg = segmentIndex(endIdx - 1);
+	for (size_t segIdx = segmentIndex(startIdx); segIdx <= lastSeg; segIdx++)
+		getSegment(segIdx);
+}
+
+TEMPL_DECL
+size_t CVECTOR_DECL::push_back(const T& val)
+{
+	size_t idx = _size.fetch_add(1, _STD memory_order_relaxed);
+	size_t segIdx = segmentIndex(idx);
+	T* pEntry = getSegment(segIdx) + (idx - segmentStart(segIdx));
+
+	pEntry->~T();
+	new(pEntry) T(val);
+
+	return idx;
+}
+
+TEMPL_DECL
+size_t CVECTOR_DECL::grow_by(size_t num)
+{
+	// Entries come from local_heap::alloc, so they are already default constructed.
+	size_t startIdx = _size.fetch_add(num, _STD memory_order_relaxed);
+	ensureSegments(startIdx, startIdx + num);
+	return startIdx;
+}
+
+TEMPL_DECL
+size_t CVECTOR_DECL::grow_by(size_t num, const T& val)
+{
+	size_t startIdx = grow_by(num);
+	for (size_t i = startIdx; i < startIdx + num; i++) {
+		T* pEntry = &operator[](i);
+		pEntry->~T();
+		new(pEntry) T(val);
+	}
+	return startIdx;
+}
+
+TEMPL_DECL
+void CVECTOR_DECL::reserve(size_t val)
+{
+	ensureSegments(0, val);
+}
+
+TEMPL_DECL
+inline size_t CVECTOR_DECL::size() const
+{
+	return _size.load(_STD memory_order_acquire);
+}
+
+TEMPL_DECL
+inline bool CVECTOR_DECL::empty() const
+{
+	return size() == 0;
+}
+
+TEMPL_DECL
+size_t CVECTOR_DECL::capacity() const
+{
+	// Segments are installed by whichever thread reaches them first, a higher one can exist before a lower one
+	for (size_t segIdx = CV_NUM_SEGMENTS; segIdx-- > 0; ) {
+		if (_segments[segIdx].load(_STD memory_order_acquire))
+			return segmentStart(segIdx) + segmentSize(segIdx);
+	}
+	return 0;
+}
+
+TEMPL_DECL
+inline const T& CVECTOR_DECL::operator[](size_t idx) const
+{
+	size_t segIdx = segmentIndex(idx);
+	return _segments[segIdx].load(_STD memory_order_acquire)[idx - segmentStart(segIdx)];
+}
+
+TEMPL_DECL
+inline T& CVECTOR_DECL::operator[](size_t idx)
+{
+	size_t segIdx = segmentIndex(idx);
+	return _segments[segIdx].load(_STD memory_order_acquire)[idx - segmentStart(segIdx)];
+}
+
+TEMPL_DECL
+void CVECTOR_DECL::clear()
+{
+	for (size_t segIdx = 0; segIdx < CV_NUM_SEGMENTS; segIdx++) {
+		T* pSeg = _segments[segIdx].load(_STD memory_order_relaxed);
+		if (pSeg) {
+			_pHeap->free(pSeg); // free<T> will handle destruction for each object in local_heap
+			_segments[segIdx].store(nullptr, _STD memory_order_relaxed);
+		}
+	}
+	_size = 0;
+}
+
+TEMPL_DECL
+typename CVECTOR_DECL::const_iterator CVECTOR_DECL::begin() const noexcept
+{
+	return const_iterator(this, 0);
+}
+
+TEMPL_DECL
+typename CVECTOR_DECL::iterator CVECTOR_DECL::begin() noexcept
+{
+	return iterator(this, 0);
+}
+
+TEMPL_DECL
+typename CVECTOR_DECL::const_iterator CVECTOR_DECL::end() const noexcept
+{
+	return const_iterator(this, size());
+}
+
+TEMPL_DECL
+typename CVECTOR_DECL::iterator CVECTOR_DECL::end() noexcept
+{
+	return iterator(this, size());
+}
+
+/*************************************************************************************************/
+/*************************************************************************************************/
+/*************************************************************************************************/
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+ITER_DECL::_iterator(source* pSource, size_t idx)
+	: _pSource(pSource)
+	, _idx(idx)
+{
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline bool ITER_DECL::operator == (const _iterator& rhs) const
+{
+	return _idx == rhs._idx;
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline bool ITER_DECL::operator != (const _iterator& rhs) const
+{
+	return _idx != rhs._idx;
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline bool ITER_DECL::operator < (const _iterator& rhs) const
+{
+	return _idx < rhs._idx;
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline typename ITER_DECL_2& ITER_DECL::operator ++ ()
+{
+	_idx++;
+	return *this;
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline typename ITER_DECL_2& ITER_DECL::operator --()
+{
+	_idx--;
+	return *this;
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline typename ITER_DECL_2 ITER_DECL::operator ++ (int)
+{
+	_iterator tmp(*this);
+	++*this;
+	return tmp;
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline typename ITER_DECL_2 ITER_DECL::operator --(int)
+{
+	_iterator tmp(*this);
+	--*this;
+	return tmp;
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline typename ITER_DECL_2 ITER_DECL::operator + (size_t val) const
+{
+	return _iterator(_pSource, _idx + val);
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline typename ITER_DECL_2 ITER_DECL::operator - (size_t val) const
+{
+	return _iterator(_pSource, _idx - val);
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline size_t ITER_DECL::operator - (const _iterator& rhs) const
+{
+	return _idx - rhs._idx;
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline typename ITER_DECL_2::reference ITER_DECL::operator *() const
+{
+	return (*_pSource)[_idx];
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline typename ITER_DECL_2::pointer ITER_DECL::operator->() const
+{
+	return &(*_pSource)[_idx];
+}
+
+}
+
+#undef TEMPL_DECL
+#undef ITER_TEMPL_DECL
+#undef CVECTOR_DECL
+#undef ITER_DECL
+#undef ITER_DECL_2
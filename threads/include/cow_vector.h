@@ -0,0 +1,119 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <atomic>
+#include <vector>
+#include <local_heap.h>
+#include <pool_vector.h>
+
+namespace MultiCore
+{
+
+/*
+	Copy on write vector for cheap snapshots.
+
+	Copies share one reference counted buffer and cost O(1). The first non const access on a shared buffer duplicates
+	it, so a snapshot never sees later edits. Use a const reference for reads, non const operator[], begin(), data()
+	etc. have to assume a write.
+
+	The reference count is atomic, so snapshots can be copied to and destroyed on worker threads. The buffer lives in
+	the heap that was current when it was created and is freed there by whoever drops the last reference. local_heap
+	is not thread safe, so keep one copy alive on the owning thread until the workers are done with theirs.
+*/
+
+template<class T>
+class cow_vector {
+public:
+	using iterator = T*;
+	using const_iterator = const T*;
+
+	cow_vector();
+	cow_vector(const cow_vector& src);
+	explicit cow_vector(const MultiCore::vector<T>& src);
+	explicit cow_vector(const std::vector<T>& src);
+	cow_vector(const std::initializer_list<T>& src);
+	~cow_vector();
+
+	cow_vector& operator = (const cow_vector& rhs);
+
+	operator std::vector<T>() const;
+	operator MultiCore::vector<T>() const;
+
+	bool isShared() const;
+	size_t useCount() const;
+
+	void clear();
+	bool empty() const;
+	size_t size() const;
+	size_t capacity() const;
+	void resize(size_t val);
+	void reserve(size_t val);
+
+	iterator insert(const_iterator at, const T& val);
+	iterator erase(const_iterator at);
+	iterator erase(const_iterator begin, const_iterator end);
+
+	const_iterator begin() const noexcept;
+	iterator begin();
+	const_iterator end() const noexcept;
+	iterator end();
+
+	const T* data() const;
+	T* data();
+
+	const T& front() const;
+	T& front();
+	const T& back() const;
+	T& back();
+
+	const T& operator[](size_t idx) const;
+	T& operator[](size_t idx);
+
+	size_t push_back(const T& val);
+	void pop_back();
+
+private:
+	struct Rep {
+		_STD atomic<size_t> _refCount = 1;
+		local_heap* _pHeap = nullptr;
+		size_t _size = 0, _capacity = 0;
+		T* _pData = nullptr;
+	};
+
+	static Rep* createRep(size_t capacity);
+	static void release(Rep*& pRep);
+
+	void makeUnique();
+	void grow(size_t needed);
+
+	Rep* _pRep = nullptr;
+};
+
+}
+
+#include <cow_vector.hpp>
@@ -0,0 +1,385 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <assert.h>
+#include <cow_vector.h>
+
+#define TEMPL_DECL template<class T> 
+#define COW_DECL cow_vector<T> 
+
+namespace MultiCore {
+
+TEMPL_DECL
+typename COW_DECL::Rep* COW_DECL::createRep(size_t capacity)
+{
+	local_heap* pHeap = local_heap::getThreadHeapPtr();
+	Rep* pRep = pHeap->alloc<Rep>(1);
+	pRep->_pHeap = pHeap;
+	if (capacity > 0) {
+		pRep->_pData = pHeap->alloc<T>(capacity);
+		pRep->_capacity = capacity;
+	}
+	return pRep;
+}
+
+TEMPL_DECL
+void COW_DECL::release(Rep*& pRep)
+{
+	if (pRep && pRep->_refCount.fetch_sub(1, _STD memory_order_acq_rel) == 1) {
+		local_heap* pHeap = pRep->_pHeap;
+		if (pRep->_pData)
+			pHeap->free(pRep->_pData);
+		pHeap->free(pRep);
+	}
+	pRep = nullptr;
+}
+
+TEMPL_DECL
+void COW_DECL::makeUnique()
+{
+	if (!_pRep) {
+		_pRep = createRep(0);
+	} else if (_pRep->_refCount.load(_STD memory_order_acquire) > 1) {
+		Rep* pCopy = createRep(_pRep->_size);
+		for (size_t i = 0; i < _pRep->_size; i++)
+			pCopy->_pData[i] = _pRep->_pData[i];
+		pCopy->_size = _pRep->_size;
+		release(_pRep);
+		_pRep = pCopy;
+	}
+}
+
+TEMPL_DECL
+void COW_DECL::grow(size_t needed)
+{
+	// Only called on an unshared buffer, stays in the buffer's heap
+	assert(_pRep && _pRep->_refCount.load() == 1);
+	if (needed <= _pRep->_capacity)
+		return;
+
+	size_t newCapacity = _pRep->_capacity + _pRep->_capacity / 2;
+	if (newCapacity < 8)
+		newCapacity = 8;
+	if (newCapacity < needed)
+		newCapacity = needed;
+
+	local_heap* pHeap = _pRep->_pHeap;
+	T* pTmp = _pRep->_pData;
+	_pRep->_pData = pHeap->alloc<T>(newCapacity);
+	if (pTmp) {
+		for (size_t i = 0; i < _pRep->_size; i++)
+			_pRep->_pData[i] = pTmp[i];
+		pHeap->free(pTmp);
+	}
+	_pRep->_capacity = newCapacity;
+}
+
+TEMPL_DECL
+COW_DECL::cow_vector()
+{
+}
+
+TEMPL_DECL
+COW_DECL::cow_vector(const cow_vector& src)
+	: _pRep(src._pRep)
+{
+	if (_pRep)
+		_pRep->_refCount.fetch_add(1, _STD memory_order_relaxed);
+}
+
+TEMPL_DECL
+COW_DECL::cow_vector(const MultiCore::vector<T>& src)
+{
+	if (!src.empty()) {
+		_pRep = createRep(src.size());
+		for (size_t i = 0; i < src.size(); i++)
+			_pRep->_pData[i] = src[i];
+		_pRep->_size = src.size();
+	}
+}
+
+TEMPL_DECL
+COW_DECL::cow_vector(const std::vector<T>& src)
+{
+	if (!src.empty()) {
+		_pRep = createRep(src.size());
+		for (size_t i = 0; i < src.size(); i++)
+			_pRep->_pData[i] = src[i];
+		_pRep->_size = src.size();
+	}
+}
+
+TEMPL_DECL
+COW_DECL::cow_vector(const std::initializer_list<T>& src)
+{
+	if (src.size() > 0) {
+		_pRep = createRep(src.size());
+		for (const auto& val : src)
+			_pRep->_pData[_pRep->_size++] = val;
+	}
+}
+
+TEMPL_DECL
+COW_DECL::~cow_vector()
+{
+	release(_pRep);
+}
+
+TEMPL_DECL
+COW_DECL& COW_DECL::operator = (const cow_vector& rhs)
+{
+	if (_pRep != rhs._pRep) {
+		if (rhs._pRep)
+			rhs._pRep->_refCount.fetch_add(1, _STD memory_order_relaxed);
+		release(_pRep);
+		_pRep = rhs._pRep;
+	}
+	return *this;
+}
+
+TEMPL_DECL
+COW_DECL::operator std::vector<T>() const
+{
+	return std::vector<T>(begin(), end());
+}
+
+TEMPL_DECL
+COW_DECL::operator MultiCore::vector<T>() const
+{
+	MultiCore::vector<T> result;
+	result.reserve(size());
+	for (const auto& val : *this)
+		result.push_back(val);
+	return result;
+}
+
+TEMPL_DECL
+inline bool COW_DECL::isShared() const
+{
+	return useCount() > 1;
+}
+
+TEMPL_DECL
+inline size_t COW_DECL::useCount() const
+{
+	return _pRep ? _pRep->_refCount.load(_STD memory_order_acquire) : 0;
+}
+
+TEMPL_DECL
+void COW_DECL::clear()
+{
+	// Drop our reference rather than copying contents we're about to discard
+	if (isShared())
+		release(_pRep);
+	else if (_pRep)
+		_pRep->_size = 0;
+}
+
+TEMPL_DECL
+inline bool COW_DECL::empty() const
+{
+	return size() == 0;
+}
+
+TEMPL_DECL
+inline size_t COW_DECL::size() const
+{
+	return _pRep ? _pRep->_size : 0;
+}
+
+TEMPL_DECL
+inline size_t COW_DECL::capacity() const
+{
+	return _pRep ? _pRep->_capacity : 0;
+}
+
+TEMPL_DECL
+void COW_DECL::resize(size_t val)
+{
+	makeUnique();
+	grow(val);
+	for (size_t i = _pRep->_size; i < val; i++)
+		_pRep->_pData[i] = T();
+	_pRep->_size = val;
+}
+
+TEMPL_DECL
+void COW_DECL::reserve(size_t val)
+{
+	makeUnique();
+	grow(val);
+}
+
+TEMPL_DECL
+typename COW_DECL::iterator COW_DECL::insert(const_iterator at, const T& val)
+{
+	// Index into the current buffer, begin() would detach first and leave 'at' pointing into the shared one
+	const_iterator pBegin = _pRep ? _pRep->_pData : nullptr;
+	size_t idx = at - pBegin;
+	assert(idx <= size());
+	makeUnique();
+	grow(_pRep->_size + 1);
+
+	T* pData = _pRep->_pData;
+	for (size_t i = _pRep->_size; i > idx; i--)
+		pData[i] = pData[i - 1];
+	pData[idx] = val;
+	_pRep->_size++;
+
+	return pData + idx;
+}
+
+TEMPL_DECL
+typename COW_DECL::iterator COW_DECL::erase(const_iterator at)
+{
+	return erase(at, at + 1);
+}
+
+TEMPL_DECL
+typename COW_DECL::iterator COW_DECL::erase(const_iterator beginIn, const_iterator endIn)
+{
+	const_iterator pBegin = _pRep ? _pRep->_pData : nullptr;
+	size_t idx0 = beginIn - pBegin;
+	size_t idx1 = endIn - pBegin;
+	assert(idx0 <= idx1 && idx1 <= size());
+	makeUnique();
+
+	T* pData = _pRep->_pData;
+	size_t num = idx1 - idx0;
+	for (size_t i = idx1; i < _pRep->_size; i++)
+		pData[i - num] = pData[i];
+	_pRep->_size -= num;
+
+	return pData + idx0;
+}
+
+TEMPL_DECL
+inline typename COW_DECL::const_iterator COW_DECL::begin() const noexcept
+{
+	return _pRep ? _pRep->_pData : nullptr;
+}
+
+TEMPL_DECL
+inline typename COW_DECL::iterator COW_DECL::begin()
+{
+	return data();
+}
+
+TEMPL_DECL
+inline typename COW_DECL::const_iterator COW_DECL::end() const noexcept
+{
+	return _pRep ? _pRep->_pData + _pRep->_size : nullptr;
+}
+
+TEMPL_DECL
+inline typename COW_DECL::iterator COW_DECL::end()
+{
+	T* pData = data();
+	return pData ? pData + _pRep->_size : nullptr;
+}
+
+TEMPL_DECL
+inline const T* COW_DECL::data() const
+{
+	return begin();
+}
+
+TEMPL_DECL
+inline T* COW_DECL::data()
+{
+	if (!_pRep)
+		return nullptr;
+	makeUnique();
+	return _pRep->_pData;
+}
+
+TEMPL_DECL
+inline const T& COW_DECL::front() const
+{
+	assert(!empty());
+	return _pRep->_pData[0];
+}
+
+TEMPL_DECL
+inline T& COW_DECL::front()
+{
+	assert(!empty());
+	return data()[0];
+}
+
+TEMPL_DECL
+inline const T& COW_DECL::back() const
+{
+	assert(!empty());
+	return _pRep->_pData[_pRep->_size - 1];
+}
+
+TEMPL_DECL
+inline T& COW_DECL::back()
+{
+	assert(!empty());
+	return data()[_pRep->_size - 1];
+}
+
+TEMPL_DECL
+inline const T& COW_DECL::operator[](size_t idx) const
+{
+	assert(idx < size());
+	return _pRep->_pData[idx];
+}
+
+TEMPL_DECL
+inline T& COW_DECL::operator[](size_t idx)
+{
+	assert(idx < size());
+	return data()[idx];
+}
+
+TEMPL_DECL
+size_t COW_DECL::push_back(const T& val)
+{
+	// val may refer into our own buffer, copy it before a duplicate or grow can move it
+	T tmp(val);
+	makeUnique();
+	grow(_pRep->_size + 1);
+	_pRep->_pData[_pRep->_size++] = tmp;
+	return _pRep->_size;
+}
+
+TEMPL_DECL
+void COW_DECL::pop_back()
+{
+	assert(!empty());
+	makeUnique();
+	_pRep->_size--;
+}
+
+}
+
+#undef TEMPL_DECL
+#undef COW_DECL
@@ -0,0 +1,108 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <stdint.h>
+#include <local_heap.h>
+
+namespace MultiCore
+{
+
+/*
+	Run time sized bitset on the local_heap, for mark and sweep liveness passes and occupancy tables.
+
+	Bits are packed into 64 bit words. The bulk operations (and/or/xor/and_not, set/reset all) are plain loops over
+	words which the compiler vectorizes. count() uses std::popcount with four independent accumulators so it issues
+	one POPCNT per word (or the vector popcount where the target has one). find_first/find_next skip empty words
+	and use count trailing zeros inside a word.
+
+	Bits past size() in the last word are always kept zero so count and the scans never need masking.
+*/
+
+class dynamic_bitset : private local_heap_user {
+public:
+	using word_type = uint64_t;
+	static constexpr size_t BITS_PER_WORD = 64;
+	static constexpr size_t npos = (size_t)-1;
+
+	dynamic_bitset(size_t numBits = 0, bool val = false);
+	dynamic_bitset(const dynamic_bitset& src);
+	~dynamic_bitset();
+
+	dynamic_bitset& operator = (const dynamic_bitset& rhs);
+
+	void clear();
+	bool empty() const;
+	size_t size() const;
+	void resize(size_t numBits, bool val = false);
+
+	bool test(size_t idx) const;
+	bool operator[](size_t idx) const;
+	void set(size_t idx);
+	void set(size_t idx, bool val);
+	void reset(size_t idx);
+	void flip(size_t idx);
+
+	void set();
+	void reset();
+
+	size_t count() const;
+	bool any() const;
+	bool none() const;
+	bool all() const;
+
+	// Returns npos if there is no set bit
+	size_t find_first() const;
+	size_t find_next(size_t prevIdx) const;
+
+	// Calls f(size_t idx) for each set bit in increasing order
+	template<class L>
+	void for_each_set(L f) const;
+
+	// The sizes must match
+	dynamic_bitset& operator &= (const dynamic_bitset& rhs);
+	dynamic_bitset& operator |= (const dynamic_bitset& rhs);
+	dynamic_bitset& operator ^= (const dynamic_bitset& rhs);
+	dynamic_bitset& and_not(const dynamic_bitset& rhs); // this &= ~rhs
+
+	bool operator == (const dynamic_bitset& rhs) const;
+	bool operator != (const dynamic_bitset& rhs) const;
+
+	size_t numWords() const;
+	const word_type* data() const;
+
+private:
+	static size_t wordsFor(size_t numBits);
+	void clearTail();
+
+	size_t _numBits = 0, _numWords = 0, _capacityWords = 0;
+	word_type* _pWords = nullptr;
+};
+
+}
+
+#include <dynamic_bitset.hpp>
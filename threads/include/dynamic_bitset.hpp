@@ -0,0 +1,307 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <assert.h>
+#include <bit>
+#include <dynamic_bitset.h>
+
+namespace MultiCore {
+
+inline dynamic_bitset::dynamic_bitset(size_t numBits, bool val)
+{
+	resize(numBits, val);
+}
+
+inline dynamic_bitset::dynamic_bitset(const dynamic_bitset& src)
+{
+	*this = src;
+}
+
+inline dynamic_bitset::~dynamic_bitset()
+{
+	free(_pWords);
+}
+
+inline dynamic_bitset& dynamic_bitset::operator = (const dynamic_bitset& rhs)
+{
+	if (this == &rhs)
+		return *this;
+
+	resize(rhs._numBits);
+	for (size_t i = 0; i < _numWords; i++)
+		_pWords[i] = rhs._pWords[i];
+	return *this;
+}
+
+inline size_t dynamic_bitset::wordsFor(size_t numBits)
+{
+	return (numBits + BITS_PER_WORD - 1) / BITS_PER_WORD;
+}
+
+inline void dynamic_bitset::clearTail()
+{
+	size_t numTailBits = _numBits % BITS_PER_WORD;
+	if (numTailBits != 0)
+		_pWords[_numWords - 1] &= ((word_type)1 << numTailBits) - 1;
+}
+
+inline void dynamic_bitset::clear()
+{
+	resize(0);
+}
+
+inline bool dynamic_bitset::empty() const
+{
+	return _numBits == 0;
+}
+
+inline size_t dynamic_bitset::size() const
+{
+	return _numBits;
+}
+
+inline void dynamic_bitset::resize(size_t numBits, bool val)
+{
+	size_t oldBits = _numBits;
+	size_t newWords = wordsFor(numBits);
+	if (newWords > _capacityWords) {
+		size_t newCapacity = _capacityWords + _capacityWords / 2;
+		if (newCapacity < newWords)
+			newCapacity = newWords;
+
+		word_type* pTmp = _pWords;
+		_pWords = alloc<word_type>(newCapacity);
+		for (size_t i = 0; i < _numWords; i++)
+			_pWords[i] = pTmp[i];
+		free(pTmp);
+		_capacityWords = newCapacity;
+	}
+
+	for (size_t i = _numWords; i < newWords; i++)
+		_pWords[i] = 0;
+	_numWords = newWords;
+	_numBits = numBits;
+
+	if (val && numBits > oldBits) {
+		// Finish the partial word, then whole words
+		size_t idx = oldBits;
+		for (; idx < numBits && idx % BITS_PER_WORD != 0; idx++)
+			set(idx);
+		for (size_t i = wordsFor(idx); i < _numWords; i++)
+			_pWords[i] = ~(word_type)0;
+	}
+
+	if (_numWords > 0)
+		clearTail();
+}
+
+inline bool dynamic_bitset::test(size_t idx) const
+{
+	assert(idx < _numBits);
+	return (_pWords[idx / BITS_PER_WORD] >> (idx % BITS_PER_WORD)) & 1;
+}
+
+inline bool dynamic_bitset::operator[](size_t idx) const
+{
+	return test(idx);
+}
+
+inline void dynamic_bitset::set(size_t idx)
+{
+	assert(idx < _numBits);
+	_pWords[idx / BITS_PER_WORD] |= (word_type)1 << (idx % BITS_PER_WORD);
+}
+
+inline void dynamic_bitset::set(size_t idx, bool val)
+{
+	if (val)
+		set(idx);
+	else
+		reset(idx);
+}
+
+inline void dynamic_bitset::reset(size_t idx)
+{
+	assert(idx < _numBits);
+	_pWords[idx / BITS_PER_WORD] &= ~((word_type)1 << (idx % BITS_PER_WORD));
+}
+
+inline void dynamic_bitset::flip(size_t idx)
+{
+	assert(idx < _numBits);
+	_pWords[idx / BITS_PER_WORD] ^= (word_type)1 << (idx % BITS_PER_WORD);
+}
+
+inline void dynamic_bitset::set()
+{
+	for (size_t i = 0; i < _numWords; i++)
+		_pWords[i] = ~(word_type)0;
+	if (_numWords > 0)
+		clearTail();
+}
+
+inline void dynamic_bitset::reset()
+{
+	for (size_t i = 0; i < _numWords; i++)
+		_pWords[i] = 0;
+}
+
+inline size_t dynamic_bitset::count() const
+{
+	// Independent accumulators so the popcounts don't serialize on one add chain
+	size_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+	size_t i = 0;
+	for (; i + 4 <= _numWords; i += 4) {
+		c0 += (size_t)_STD popcount(_pWords[i]);
+		c1 += (size_t)_STD popcount(_pWords[i + 1]);
+		c2 += (size_t)_STD popcount(_pWords[i + 2]);
+		c3 += (size_t)_STD popcount(_pWords[i + 3]);
+	}
+	for (; i < _numWords; i++)
+		c0 += (size_t)_STD popcount(_pWords[i]);
+
+	return c0 + c1 + c2 + c3;
+}
+
+inline bool dynamic_bitset::any() const
+{
+	for (size_t i = 0; i < _numWords; i++) {
+		if (_pWords[i])
+			return true;
+	}
+	return false;
+}
+
+inline bool dynamic_bitset::none() const
+{
+	return !any();
+}
+
+inline bool dynamic_bitset::all() const
+{
+	return count() == _numBits;
+}
+
+inline size_t dynamic_bitset::find_first() const
+{
+	for (size_t i = 0; i < _numWords; i++) {
+		if (_pWords[i])
+			return i * BITS_PER_WORD + (size_t)_STD countr_zero(_pWords[i]);
+	}
+	return npos;
+}
+
+inline size_t dynamic_bitset::find_next(size_t prevIdx) const
+{
+	size_t idx = prevIdx + 1;
+	if (prevIdx == npos || idx >= _numBits)
+		return npos;
+
+	size_t wordIdx = idx / BITS_PER_WORD;
+	word_type word = _pWords[wordIdx] & (~(word_type)0 << (idx % BITS_PER_WORD));
+	while (true) {
+		if (word)
+			return wordIdx * BITS_PER_WORD + (size_t)_STD countr_zero(word);
+		if (++wordIdx >= _numWords)
+			break;
+		word = _pWords[wordIdx];
+	}
+	return npos;
+}
+
+template<class L>
+void dynamic_bitset::for_each_set(L f) const
+{
+	for (size_t i = 0; i < _numWords; i++) {
+		word_type word = _pWords[i];
+		while (word) {
+			f(i * BITS_PER_WORD + (size_t)_STD countr_zero(word));
+			word &= word - 1; // Clear the lowest set bit
+		}
+	}
+}
+
+inline dynamic_bitset& dynamic_bitset::operator &= (const dynamic_bitset& rhs)
+{
+	assert(_numBits == rhs._numBits);
+	for (size_t i = 0; i < _numWords; i++)
+		_pWords[i] &= rhs._pWords[i];
+	return *this;
+}
+
+inline dynamic_bitset& dynamic_bitset::operator |= (const dynamic_bitset& rhs)
+{
+	assert(_numBits == rhs._numBits);
+	for (size_t i = 0; i < _numWords; i++)
+		_pWords[i] |= rhs._pWords[i];
+	return *this;
+}
+
+inline dynamic_bitset& dynamic_bitset::operator ^= (const dynamic_bitset& rhs)
+{
+	assert(_numBits == rhs._numBits);
+	for (size_t i = 0; i < _numWords; i++)
+		_pWords[i] ^= rhs._pWords[i];
+	return *this;
+}
+
+inline dynamic_bitset& dynamic_bitset::and_not(const dynamic_bitset& rhs)
+{
+	assert(_numBits == rhs._numBits);
+	for (size_t i = 0; i < _numWords; i++)
+		_pWords[i] &= ~rhs._pWords[i];
+	return *this;
+}
+
+inline bool dynamic_bitset::operator == (const dynamic_bitset& rhs) const
+{
+	if (_numBits != rhs._numBits)
+		return false;
+	for (size_t i = 0; i < _numWords; i++) {
+		if (_pWords[i] != rhs._pWords[i])
+			return false;
+	}
+	return true;
+}
+
+inline bool dynamic_bitset::operator != (const dynamic_bitset& rhs) const
+{
+	return !operator == (rhs);
+}
+
+inline size_t dynamic_bitset::numWords() const
+{
+	return _numWords;
+}
+
+inline const dynamic_bitset::word_type* dynamic_bitset::data() const
+{
+	return _pWords;
+}
+
+}
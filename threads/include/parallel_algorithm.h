@@ -0,0 +1,244 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <vector>
+#include <MultiCoreUtil.h>
+#include <pool_vector.h>
+
+#define PARALLEL_BLOCK_SIZE 2048
+#define PARALLEL_CACHE_LINE 64
+
+namespace MultiCore
+{
+
+/*
+	Reduce, scan and for_each run on an existing ThreadPool.
+
+	The range is cut into blocks of blockSize, never into one piece per thread. Each block is folded left to right and
+	the block partials are combined left to right, so the result depends only on the data and blockSize, not on
+	the thread count or on which thread ran which block. This holds even for non-associative combiners like float
+	addition. The partials sit on their own cache lines.
+
+	Scans are two pass: reduce each block, scan the block partials serially, then rescan each block from its offset.
+	pOut may equal pIn.
+*/
+
+template<class T>
+struct alignas(PARALLEL_CACHE_LINE) padded_value {
+	T _value;
+};
+
+// Combines map(idx) for idx in [0, num), starting from identity
+template<class T, class M, class C>
+T parallel_reduce(const ThreadPool& pool, size_t num, const T& identity, const M& map, const C& combine, bool multiCore, size_t blockSize = PARALLEL_BLOCK_SIZE)
+{
+	if (blockSize == 0)
+		blockSize = 1;
+	const size_t numBlocks = (num + blockSize - 1) / blockSize;
+
+	_STD vector<padded_value<T>> partials(numBlocks, padded_value<T>{ identity });
+	pool.run(numBlocks, [num, blockSize, &identity, &map, &combine, &partials](size_t threadNum, size_t block)->bool {
+		size_t end = _STD min(num, (block + 1) * blockSize);
+		T acc = identity;
+		for (size_t i = block * blockSize; i < end; i++)
+			acc = combine(acc, map(i));
+		partials[block]._value = acc;
+		return true;
+	}, multiCore, Partitioner::dynamic());
+
+	T result = identity;
+	for (const auto& partial : partials)
+		result = combine(result, partial._value);
+
+	return result;
+}
+
+template<class T, class C>
+T parallel_reduce(const ThreadPool& pool, const T* pBegin, const T* pEnd, const T& identity, const C& combine, bool multiCore, size_t blockSize = PARALLEL_BLOCK_SIZE)
+{
+	return parallel_reduce(pool, (size_t)(pEnd - pBegin), identity, [pBegin](size_t i)->const T& {
+		return pBegin[i];
+	}, combine, multiCore, blockSize);
+}
+
+template<class T, class C>
+inline T parallel_reduce(const ThreadPool& pool, const MultiCore::vector<T>& vec, const T& identity, const C& combine, bool multiCore)
+{
+	return parallel_reduce(pool, vec.data(), vec.data() + vec.size(), identity, combine, multiCore);
+}
+
+template<class T, class C>
+inline T parallel_reduce(const ThreadPool& pool, const _STD vector<T>& vec, const T& identity, const C& combine, bool multiCore)
+{
+	return parallel_reduce(pool, vec.data(), vec.data() + vec.size(), identity, combine, multiCore);
+}
+
+// pOut[i] = pIn[0] + ... + pIn[i]
+template<class T, class C>
+void parallel_inclusive_scan(const ThreadPool& pool, const T* pIn, const T* pInEnd, T* pOut, const C& combine, bool multiCore, size_t blockSize = PARALLEL_BLOCK_SIZE)
+{
+	const size_t num = (size_t)(pInEnd - pIn);
+	if (num == 0)
+		return;
+	if (blockSize == 0)
+		blockSize = 1;
+	const size_t numBlocks = (num + blockSize - 1) / blockSize;
+
+	_STD vector<padded_value<T>> partials(numBlocks, padded_value<T>{ pIn[0] });
+	pool.run(numBlocks, [pIn, num, blockSize, &combine, &partials](size_t threadNum, size_t block)->bool {
+		size_t begin = block * blockSize;
+		size_t end = _STD min(num, begin + blockSize);
+		T acc = pIn[begin];
+		for (size_t i = begin + 1; i < end; i++)
+			acc = combine(acc, pIn[i]);
+		partials[block]._value = acc;
+		return true;
+	}, multiCore, Partitioner::dynamic());
+
+	// partials[block] becomes the combination of all blocks before it, block 0 has none
+	T running = partials[0]._value;
+	for (size_t block = 1; block < numBlocks; block++) {
+		T blockTotal = partials[block]._value;
+		partials[block]._value = running;
+		running = combine(running, blockTotal);
+	}
+
+	pool.run(numBlocks, [pIn, pOut, num, blockSize, &combine, &partials](size_t threadNum, size_t block)->bool {
+		size_t begin = block * blockSize;
+		size_t end = _STD min(num, begin + blockSize);
+		T acc = block == 0 ? pIn[begin] : combine(partials[block]._value, pIn[begin]);
+		pOut[begin] = acc;
+		for (size_t i = begin + 1; i < end; i++) {
+			acc = combine(acc, pIn[i]);
+			pOut[i] = acc;
+		}
+		return true;
+	}, multiCore, Partitioner::dynamic());
+}
+
+// pOut[i] = init + pIn[0] + ... + pIn[i - 1]
+template<class T, class C>
+void parallel_exclusive_scan(const ThreadPool& pool, const T* pIn, const T* pInEnd, T* pOut, const T& init, const C& combine, bool multiCore, size_t blockSize = PARALLEL_BLOCK_SIZE)
+{
+	const size_t num = (size_t)(pInEnd - pIn);
+	if (num == 0)
+		return;
+	if (blockSize == 0)
+		blockSize = 1;
+	const size_t numBlocks = (num + blockSize - 1) / blockSize;
+
+	_STD vector<padded_value<T>> partials(numBlocks, padded_value<T>{ init });
+	pool.run(numBlocks, [pIn, num, blockSize, &combine, &partials](size_t threadNum, size_t block)->bool {
+		size_t begin = block * blockSize;
+		size_t end = _STD min(num, begin + blockSize);
+		T acc = pIn[begin];
+		for (size_t i = begin + 1; i < end; i++)
+			acc = combine(acc, pIn[i]);
+		partials[block]._value = acc;
+		return true;
+	}, multiCore, Partitioner::dynamic());
+
+	T running = init;
+	for (size_t block = 0; block < numBlocks; block++) {
+		T blockTotal = partials[block]._value;
+		partials[block]._value = running;
+		running = combine(running, blockTotal);
+	}
+
+	pool.run(numBlocks, [pIn, pOut, num, blockSize, &combine, &partials](size_t threadNum, size_t block)->bool {
+		size_t begin = block * blockSize;
+		size_t end = _STD min(num, begin + blockSize);
+		T acc = partials[block]._value;
+		for (size_t i = begin; i < end; i++) {
+			T val = pIn[i]; // pOut may be pIn
+			pOut[i] = acc;
+			acc = combine(acc, val);
+		}
+		return true;
+	}, multiCore, Partitioner::dynamic());
+}
+
+template<class T, class C>
+inline void parallel_inclusive_scan(const ThreadPool& pool, MultiCore::vector<T>& vec, const C& combine, bool multiCore)
+{
+	parallel_inclusive_scan(pool, vec.data(), vec.data() + vec.size(), vec.data(), combine, multiCore);
+}
+
+template<class T, class C>
+inline void parallel_inclusive_scan(const ThreadPool& pool, _STD vector<T>& vec, const C& combine, bool multiCore)
+{
+	parallel_inclusive_scan(pool, vec.data(), vec.data() + vec.size(), vec.data(), combine, multiCore);
+}
+
+template<class T, class C>
+inline void parallel_exclusive_scan(const ThreadPool& pool, MultiCore::vector<T>& vec, const T& init, const C& combine, bool multiCore)
+{
+	parallel_exclusive_scan(pool, vec.data(), vec.data() + vec.size(), vec.data(), init, combine, multiCore);
+}
+
+template<class T, class C>
+inline void parallel_exclusive_scan(const ThreadPool& pool, _STD vector<T>& vec, const T& init, const C& combine, bool multiCore)
+{
+	parallel_exclusive_scan(pool, vec.data(), vec.data() + vec.size(), vec.data(), init, combine, multiCore);
+}
+
+// Calls f(entry) for every entry of range. Any range with size() and operator[] works, MultiCore::vector,
+// std::vector, std::array, std::deque, std::span...
+template<class R, class F>
+void parallel_for_each(const ThreadPool& pool, R& range, const F& f, bool multiCore, size_t blockSize = PARALLEL_BLOCK_SIZE)
+{
+	const size_t num = range.size();
+	if (blockSize == 0)
+		blockSize = 1;
+	const size_t numBlocks = (num + blockSize - 1) / blockSize;
+
+	pool.run(numBlocks, [&range, &f, num, blockSize](size_t threadNum, size_t block)->bool {
+		size_t end = _STD min(num, (block + 1) * blockSize);
+		for (size_t i = block * blockSize; i < end; i++)
+			f(range[i]);
+		return true;
+	}, multiCore, Partitioner::dynamic());
+}
+
+template<class T, class F>
+void parallel_for_each(const ThreadPool& pool, T* pBegin, T* pEnd, const F& f, bool multiCore, size_t blockSize = PARALLEL_BLOCK_SIZE)
+{
+	const size_t num = (size_t)(pEnd - pBegin);
+	if (blockSize == 0)
+		blockSize = 1;
+	const size_t numBlocks = (num + blockSize - 1) / blockSize;
+
+	pool.run(numBlocks, [pBegin, &f, num, blockSize](size_t threadNum, size_t block)->bool {
+		size_t end = _STD min(num, (block + 1) * blockSize);
+		for (size_t i = block * blockSize; i < end; i++)
+			f(pBegin[i]);
+		return true;
+	}, multiCore, Partitioner::dynamic());
+}
+
+}
@@ -0,0 +1,197 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <MultiCoreUtil.h>
+#include <pool_vector.h>
+#include <pool_set.h>
+#include <pool_map.h>
+
+#define PARALLEL_SORT_MIN_SIZE 4096
+
+namespace MultiCore
+{
+
+/*
+	Parallel sort and bulk build for the sorted containers, run on an existing ThreadPool.
+
+	The range is cut into one chunk per pool thread and each chunk is stable sorted by a worker. Splitters are chosen by
+	regular sampling of the sorted chunks, which cuts every chunk into one piece per output partition. Each worker then
+	does a k-way merge of its partition into a scratch buffer, ties going to the lower chunk.
+
+	Every step is stable, so the result is identical to std::stable_sort regardless of the number of threads. The bulk
+	builds keep the first of equivalent entries, the same as inserting them one at a time.
+*/
+
+template<class T, class C>
+void parallel_sort(const ThreadPool& pool, T* pBegin, T* pEnd, const C& comp, bool multiCore)
+{
+	const size_t num = (size_t)(pEnd - pBegin);
+	const size_t numChunks = _STD max((size_t)1, pool.getNumThreads());
+	if (!multiCore || numChunks == 1 || num < PARALLEL_SORT_MIN_SIZE) {
+		_STD stable_sort(pBegin, pEnd, comp);
+		return;
+	}
+
+	_STD vector<size_t> chunkStart(numChunks + 1);
+	for (size_t i = 0; i <= numChunks; i++)
+		chunkStart[i] = (num * i) / numChunks;
+
+	pool.run(numChunks, [pBegin, &chunkStart, &comp](size_t threadNum, size_t chunk)->bool {
+		_STD stable_sort(pBegin + chunkStart[chunk], pBegin + chunkStart[chunk + 1], comp);
+		return true;
+	}, multiCore);
+
+	// Regular sampling. Each chunk contributes numChunks - 1 evenly spaced samples.
+	const size_t numParts = numChunks;
+	_STD vector<T> samples;
+	samples.reserve(numChunks * (numParts - 1));
+	for (size_t chunk = 0; chunk < numChunks; chunk++) {
+		size_t chunkSize = chunkStart[chunk + 1] - chunkStart[chunk];
+		for (size_t j = 1; j < numParts; j++)
+			samples.push_back(pBegin[chunkStart[chunk] + (chunkSize * j) / numParts]);
+	}
+	_STD sort(samples.begin(), samples.end(), comp);
+
+	// bounds[part * numChunks + chunk] is where partition part starts within chunk.
+	// Using lower_bound on every chunk puts all equivalent entries in the same partition.
+	_STD vector<size_t> bounds((numParts + 1) * numChunks);
+	for (size_t chunk = 0; chunk < numChunks; chunk++) {
+		bounds[chunk] = chunkStart[chunk];
+		bounds[numParts * numChunks + chunk] = chunkStart[chunk + 1];
+		for (size_t part = 1; part < numParts; part++) {
+			const T& splitter = samples[(part * samples.size()) / numParts];
+			T* pChunkBegin = pBegin + bounds[(part - 1) * numChunks + chunk];
+			T* pChunkEnd = pBegin + chunkStart[chunk + 1];
+			bounds[part * numChunks + chunk] = (size_t)(_STD lower_bound(pChunkBegin, pChunkEnd, splitter, comp) - pBegin);
+		}
+	}
+
+	_STD vector<size_t> partStart(numParts + 1, 0);
+	for (size_t part = 0; part < numParts; part++) {
+		size_t partSize = 0;
+		for (size_t chunk = 0; chunk < numChunks; chunk++)
+			partSize += bounds[(part + 1) * numChunks + chunk] - bounds[part * numChunks + chunk];
+		partStart[part + 1] = partStart[part] + partSize;
+	}
+
+	_STD vector<T> scratch(num);
+	pool.run(numParts, [pBegin, numChunks, &bounds, &partStart, &scratch, &comp](size_t threadNum, size_t part)->bool {
+		_STD vector<size_t> cursor(numChunks), limit(numChunks), heap;
+		heap.reserve(numChunks);
+		for (size_t chunk = 0; chunk < numChunks; chunk++) {
+			cursor[chunk] = bounds[part * numChunks + chunk];
+			limit[chunk] = bounds[(part + 1) * numChunks + chunk];
+			if (cursor[chunk] < limit[chunk])
+				heap.push_back(chunk);
+		}
+
+		// Max heap on "comes later", so the top is the next entry out. Ties go to the lower chunk for stability.
+		auto later = [pBegin, &cursor, &comp](size_t lhs, size_t rhs)->bool {
+			const T& a = pBegin[cursor[lhs]];
+			const T& b = pBegin[cursor[rhs]];
+			if (comp(b, a))
+				return true;
+			if (comp(a, b))
+				return false;
+			return lhs > rhs;
+		};
+		_STD make_heap(heap.begin(), heap.end(), later);
+
+		size_t outIdx = partStart[part];
+		while (!heap.empty()) {
+			_STD pop_heap(heap.begin(), heap.end(), later);
+			size_t chunk = heap.back();
+			scratch[outIdx++] = pBegin[cursor[chunk]++];
+			if (cursor[chunk] < limit[chunk])
+				_STD push_heap(heap.begin(), heap.end(), later);
+			else
+				heap.pop_back();
+		}
+		return true;
+	}, multiCore);
+
+	pool.run(numParts, [pBegin, &partStart, &scratch](size_t threadNum, size_t part)->bool {
+		_STD copy(scratch.begin() + partStart[part], scratch.begin() + partStart[part + 1], pBegin + partStart[part]);
+		return true;
+	}, multiCore);
+}
+
+template<class T>
+inline void parallel_sort(const ThreadPool& pool, T* pBegin, T* pEnd, bool multiCore)
+{
+	parallel_sort(pool, pBegin, pEnd, _STD less<T>(), multiCore);
+}
+
+template<class T>
+inline void parallel_sort(const ThreadPool& pool, MultiCore::vector<T>& vec, bool multiCore)
+{
+	parallel_sort(pool, vec.data(), vec.data() + vec.size(), _STD less<T>(), multiCore);
+}
+
+template<class T>
+inline void parallel_sort(const ThreadPool& pool, _STD vector<T>& vec, bool multiCore)
+{
+	parallel_sort(pool, vec.data(), vec.data() + vec.size(), _STD less<T>(), multiCore);
+}
+
+template<class T, class ITER_TYPE>
+void parallel_build(const ThreadPool& pool, MultiCore::set<T>& dst, const ITER_TYPE& begin, const ITER_TYPE& end, bool multiCore)
+{
+	_STD vector<T> vals(begin, end);
+	parallel_sort(pool, vals.data(), vals.data() + vals.size(), _STD less<T>(), multiCore);
+	auto newEnd = _STD unique(vals.begin(), vals.end(), [](const T& lhs, const T& rhs)->bool {
+		return !(lhs < rhs) && !(rhs < lhs);
+	});
+	vals.erase(newEnd, vals.end());
+
+	dst.insert_sorted(vals.data(), vals.data() + vals.size());
+}
+
+template<class KEY, class T, class ITER_TYPE>
+void parallel_build(const ThreadPool& pool, MultiCore::map<KEY, T>& dst, const ITER_TYPE& begin, const ITER_TYPE& end, bool multiCore)
+{
+	using DataPair = typename MultiCore::map<KEY, T>::DataPair;
+
+	auto keyLess = [](const DataPair& lhs, const DataPair& rhs)->bool {
+		return lhs.first < rhs.first;
+	};
+
+	_STD vector<DataPair> vals(begin, end);
+	parallel_sort(pool, vals.data(), vals.data() + vals.size(), keyLess, multiCore);
+	auto newEnd = _STD unique(vals.begin(), vals.end(), [&keyLess](const DataPair& lhs, const DataPair& rhs)->bool {
+		return !keyLess(lhs, rhs) && !keyLess(rhs, lhs);
+	});
+	vals.erase(newEnd, vals.end());
+
+	dst.insert_sorted(vals.data(), vals.data() + vals.size());
+}
+
+}
@@ -161,6 +161,8 @@ public:
 	DataPair* data() ;
 
 	std::pair<iterator, bool> insert(const DataPair& pair);
+	// The range must be sorted by key and contain no equivalent keys. Existing keys are not overwritten.
+	void insert_sorted(const DataPair* pBegin, const DataPair* pEnd);
 
 	void erase(const iterator& at);
 	void erase(const const_iterator& at);
@@ -197,7 +199,7 @@ private:
 	::MultiCore::vector<size_t> _availEntries;
 
 #if DUPLICATE_STD_TESTS	
-	std::map<KEY, DATA> _map;
+	std::map<KEY, T> _map;
 #endif
 };
 
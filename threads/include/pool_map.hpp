@@ -38,6 +38,9 @@ This file is part of the DistFieldHexMesh application/library.
 TEMPL_DECL
 std::pair<typename MAP_DECL::iterator, bool> MAP_DECL::insert(const DataPair& pair)
 {
+#if DUPLICATE_STD_TESTS	
+	_map.insert(pair);
+#endif
 	auto keyIter = _keySet.find(KeyRec(pair.first)); // Confused about value vs index. Must be able to compare and index for a pair that isn't in the array yet.
 	if (keyIter == _keySet.end()) {
 		auto* pPair = allocEntry(pair);
@@ -55,9 +58,33 @@ std::pair<typename MAP_DECL::iterator, bool> MAP_DECL::insert(const DataPair& pa
 	return std::pair(newIter, false);
 }
 
+TEMPL_DECL
+void MAP_DECL::insert_sorted(const DataPair* pBegin, const DataPair* pEnd)
+{
+#if DUPLICATE_STD_TESTS	
+	_map.insert(pBegin, pEnd);
+#endif
+	::MultiCore::vector<KeyRec> newKeys;
+	newKeys.reserve((size_t)(pEnd - pBegin));
+	for (const DataPair* p = pBegin; p != pEnd; p++) {
+		if (_keySet.contains(KeyRec(p->first)))
+			continue;
+
+		auto* pPair = allocEntry(*p);
+		size_t idx = (size_t)(pPair - _data.data());
+		newKeys.push_back(KeyRec(p->first, &_data, idx));
+	}
+
+	// The input order is the key order, so the key set can merge them in one pass
+	_keySet.insert_sorted(newKeys.data(), newKeys.data() + newKeys.size());
+}
+
 TEMPL_DECL
 void MAP_DECL::erase(const iterator& at)
 {
+#if DUPLICATE_STD_TESTS	
+	_map.erase(at->first);
+#endif
 	DataPair* p = const_cast<DataPair*> (at.get());
 	size_t idx = (size_t)(p - _data.data());
 	*p = DataPair();
@@ -75,6 +102,9 @@ void MAP_DECL::erase(const iterator& at)
 TEMPL_DECL
 void MAP_DECL::erase(const const_iterator& at)
 {
+#if DUPLICATE_STD_TESTS	
+	_map.erase(at->first);
+#endif
 	DataPair* p = const_cast<DataPair*> (at.get());
 	size_t idx = (size_t)(p - _data.data());
 	*p = DataPair();
@@ -97,6 +127,9 @@ inline size_t MAP_DECL::size() const
 TEMPL_DECL
 void MAP_DECL::clear()
 {
+#if DUPLICATE_STD_TESTS	
+	_map.clear();
+#endif
 	_keySet.clear();
 	_data.clear();
 }
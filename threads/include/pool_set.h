@@ -53,6 +53,17 @@ public:
 
 	operator std::set<T>() const;
 
+	// Deferred sort mode is for build-then-query workloads. Inserts are appended to an unsorted staging buffer
+	// and the buffer is sorted and merged into the set on the first query (find, contains, count, size, iteration)
+	// or an explicit commit. While deferred, insert(val) returns a placeholder since the entry has no position yet.
+	// It doesn't commit, and it isn't a valid iterator, not even end(), until after the next commit.
+	// The first query writes to the set, so a deferred set isn't safe for concurrent reads, not even through a const
+	// reference, until it has been committed. Call commit() before sharing it with other threads. The queries aren't
+	// noexcept since that commit allocates.
+	void setDeferredSort(bool defer);
+	bool isDeferredSort() const;
+	void commit() const;
+
 	bool empty() const;
 	size_t size() const;
 	void clear();
@@ -61,6 +72,8 @@ public:
 	void insert(const std::initializer_list<T>& vals);
 	template<class ITER_TYPE>
 	void insert(const ITER_TYPE& begin, const ITER_TYPE& end);
+	// The range must be sorted and contain no equivalent entries. Merges in a single pass.
+	void insert_sorted(const T* pBegin, const T* pEnd);
 
 	void erase(const T& val);
 	void erase(const const_iterator& at);
@@ -68,20 +81,24 @@ public:
 
 	set& operator = (const set& rhs);
 
-	const_iterator begin() const noexcept;
-	const_iterator end() const noexcept;
+	const_iterator begin() const;
+	const_iterator end() const;
 
-	const_reverse_iterator rbegin() const noexcept;
-	const_reverse_iterator rend() const noexcept;
+	const_reverse_iterator rbegin() const;
+	const_reverse_iterator rend() const;
 
-	const_iterator find(const T& val) const noexcept;
+	const_iterator find(const T& val) const;
 	bool contains(const T& val) const;
 	size_t count(const T& val) const;
 
 protected:
-	const_iterator find(const T& val, const_iterator& next) const noexcept;
+	const_iterator find(const T& val, const_iterator& next) const;
 
 private:
+	void mergeSorted(const T* pBegin, const T* pEnd);
+
+	bool _deferSort = false;
+	mutable vector<T> _staged;
 
 #if DUPLICATE_STD_TESTS	
 	std::set<T> _set;
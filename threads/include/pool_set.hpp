@@ -27,6 +27,7 @@ This file is part of the DistFieldHexMesh application/library.
 */
 
 #include <assert.h>
+#include <algorithm>
 #include <local_heap.h>
 #include <pool_vector.h>
 
@@ -80,22 +81,104 @@ void SET_DECL::insert(const ITER_TYPE& begin, const ITER_TYPE& end)
 	}
 }
 
+TEMPL_DECL
+inline void SET_DECL::setDeferredSort(bool defer)
+{
+	if (!defer)
+		commit();
+	_deferSort = defer;
+}
+
+TEMPL_DECL
+inline bool SET_DECL::isDeferredSort() const
+{
+	return _deferSort;
+}
+
+TEMPL_DECL
+void SET_DECL::commit() const
+{
+	if (_staged.empty())
+		return;
+
+	// The staging buffer is not part of the logical state, so committing is const.
+	set& self = const_cast<set&>(*this);
+
+	// Stable sort so unique keeps the first inserted of equivalent entries, the same as immediate insertion.
+	T* pStaged = _staged.data();
+	T* pStagedEnd = pStaged + _staged.size();
+	std::stable_sort(pStaged, pStagedEnd);
+	pStagedEnd = std::unique(pStaged, pStagedEnd, [](const T& lhs, const T& rhs)->bool {
+		return !(lhs < rhs) && !(rhs < lhs);
+	});
+
+	self.mergeSorted(pStaged, pStagedEnd);
+	_staged.clear();
+}
+
+TEMPL_DECL
+inline void SET_DECL::insert_sorted(const T* pBegin, const T* pEnd)
+{
+#if DUPLICATE_STD_TESTS	
+	_set.insert(pBegin, pEnd);
+#endif
+	commit();
+	mergeSorted(pBegin, pEnd);
+}
+
+TEMPL_DECL
+void SET_DECL::mergeSorted(const T* pBegin, const T* pEnd)
+{
+	// Both ranges are sorted, walk them together to count the entries which are not already in the set.
+	const size_t oldSize = vector<T>::size();
+	const T* pOld = vector<T>::data();
+	size_t oldIdx = 0, numNew = 0;
+	for (const T* p = pBegin; p != pEnd; p++) {
+		while (oldIdx < oldSize && pOld[oldIdx] < *p)
+			oldIdx++;
+		if (oldIdx == oldSize || *p < pOld[oldIdx])
+			numNew++;
+	}
+
+	if (numNew == 0)
+		return;
+
+	// Grow once and merge from the back so every entry is moved at most once.
+	vector<T>::resize(oldSize + numNew);
+	T* pData = vector<T>::data();
+	size_t srcIdx = oldSize, newIdx = (size_t)(pEnd - pBegin), dstIdx = oldSize + numNew;
+	while (newIdx > 0) {
+		if (srcIdx > 0 && pBegin[newIdx - 1] < pData[srcIdx - 1])
+			pData[--dstIdx] = pData[--srcIdx];
+		else if (srcIdx > 0 && !(pData[srcIdx - 1] < pBegin[newIdx - 1]))
+			newIdx--; // Already present
+		else
+			pData[--dstIdx] = pBegin[--newIdx];
+	}
+	assert(dstIdx == srcIdx);
+}
+
 TEMPL_DECL
 inline bool SET_DECL::empty() const
 {
-	return vector<T>::empty();
+	return vector<T>::empty() && _staged.empty();
 }
 
 TEMPL_DECL
 inline size_t SET_DECL::size() const
 {
+	commit();
 	return vector<T>::size();
 }
 
 TEMPL_DECL
 inline void SET_DECL::clear()
 {
+#if DUPLICATE_STD_TESTS	
+	_set.clear();
+#endif
 	vector<T>::clear();
+	_staged.clear();
 }
 
 TEMPL_DECL
@@ -104,6 +187,12 @@ typename SET_DECL::const_iterator SET_DECL::insert(const T& val)
 #if DUPLICATE_STD_TESTS	
 	_set.insert(val);
 #endif
+	if (_deferSort) {
+		_staged.push_back(val);
+		// Not end(), that would commit. Only compare it against end() after a commit.
+		return static_cast<const vector<T>&>(*this).end();
+	}
+
 	const_iterator iter, nextIter;
 	iter = find(val, nextIter);
 	if (iter == end()) {
@@ -119,7 +208,7 @@ void SET_DECL::insert(const std::initializer_list<T>& vals)
 	_set.insert(vals.begin(), vals.end());
 #endif
 
-	for (auto iter = begin(); iter != end(); iter++) {
+	for (auto iter = vals.begin(); iter != vals.end(); iter++) {
 		insert(*iter);
 	}
 }
@@ -128,7 +217,7 @@ TEMPL_DECL
 inline void SET_DECL::erase(const const_iterator& at)
 {
 #if DUPLICATE_STD_TESTS	
-	//	_set.erase(_set.begin() + idx);
+	_set.erase(*at);
 #endif
 
 	vector<T>::erase(at);
@@ -146,7 +235,8 @@ TEMPL_DECL
 inline void SET_DECL::erase(const const_iterator& begin, const const_iterator& end)
 {
 #if DUPLICATE_STD_TESTS	
-	//	_set.erase(begin, end);
+	for (auto iter = begin; iter != end; iter++)
+		_set.erase(*iter);
 #endif
 	vector<T>::erase(begin, end);
 }
@@ -157,37 +247,44 @@ inline MultiCore::set<T>& SET_DECL::operator = (const set& rhs)
 #if DUPLICATE_STD_TESTS	
 	_set = rhs._set;
 #endif
+	rhs.commit();
+	_staged.clear();
+	_deferSort = rhs._deferSort;
 	vector<T>::operator = (rhs);
 
 	return *this;
 }
 
 TEMPL_DECL
-inline typename SET_DECL::const_iterator SET_DECL::begin() const noexcept
+inline typename SET_DECL::const_iterator SET_DECL::begin() const
 {
+	commit();
 	return vector<T>::begin();
 }
 
 TEMPL_DECL
-inline typename SET_DECL::const_iterator SET_DECL::end() const noexcept
+inline typename SET_DECL::const_iterator SET_DECL::end() const
 {
+	commit();
 	return vector<T>::end();
 }
 
 TEMPL_DECL
-inline typename SET_DECL::const_reverse_iterator SET_DECL::rbegin() const noexcept
+inline typename SET_DECL::const_reverse_iterator SET_DECL::rbegin() const
 {
+	commit();
 	return vector<T>::rbegin();
 }
 
 TEMPL_DECL
-inline typename SET_DECL::const_reverse_iterator SET_DECL::rend() const noexcept
+inline typename SET_DECL::const_reverse_iterator SET_DECL::rend() const
 {
+	commit();
 	return vector<T>::rend();
 }
 
 TEMPL_DECL
-inline typename SET_DECL::const_iterator SET_DECL::find(const T& val) const noexcept
+inline typename SET_DECL::const_iterator SET_DECL::find(const T& val) const
 {
 	const_iterator next;
 	return find(val, next);
@@ -206,8 +303,9 @@ inline size_t SET_DECL::count(const T& val) const
 }
 
 TEMPL_DECL
-typename SET_DECL::const_iterator SET_DECL::find(const T& val, const_iterator& next) const noexcept
+typename SET_DECL::const_iterator SET_DECL::find(const T& val, const_iterator& next) const
 {
+	commit();
 	next = end();
 	size_t min = 0;
 	size_t max = size();
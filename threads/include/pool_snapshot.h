@@ -0,0 +1,251 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <stdint.h>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <pool_vector.h>
+#include <pool_set.h>
+#include <pool_map.h>
+
+namespace MultiCore
+{
+
+/*
+	Flat binary snapshots of the pool containers.
+
+	A snapshot file is a header, the raw container images and a directory. Every image is the container's contiguous data
+	array written as is and aligned to SNAPSHOT_ALIGNMENT, so there are offsets instead of pointers and nothing to parse.
+	Maps are written as a sorted key array and a matching value array.
+
+	snapshot_reader memory maps the file read only. The snapshot_vector/set/map views read straight from the mapping.
+	Calling edit() promotes a view to a real MultiCore container, copying only that container. Unmodified containers are
+	never copied.
+
+	Only trivially copyable types can be stored. Images are native endian and native layout, they are for checkpointing
+	between stages of one build, not an archive format.
+*/
+
+#define SNAPSHOT_ALIGNMENT 64
+#define SNAPSHOT_VERSION 1
+
+class mapped_file {
+public:
+	mapped_file() = default;
+	mapped_file(const mapped_file& src) = delete;
+	~mapped_file();
+
+	mapped_file& operator = (const mapped_file& rhs) = delete;
+
+	bool open(const std::string& path);
+	void close();
+
+	bool isOpen() const;
+	const char* data() const;
+	size_t size() const;
+
+private:
+	const char* _pData = nullptr;
+	size_t _size = 0;
+#if defined(_WIN32)
+	void* _hFile = nullptr;
+	void* _hMapping = nullptr;
+#else
+	int _fd = -1;
+#endif
+};
+
+class snapshot_writer;
+class snapshot_reader;
+
+struct snapshot_file_header {
+	char _magic[8];
+	uint32_t _version;
+	uint32_t _numEntries;
+	uint64_t _dirOffset;
+};
+
+struct snapshot_entry {
+	enum Kind : uint32_t {
+		KIND_VECTOR,
+		KIND_SET,
+		KIND_MAP,
+	};
+
+	uint32_t _kind;
+	uint32_t _keySize;
+	uint32_t _valSize;
+	uint32_t _pad = 0;
+	uint64_t _count;
+	uint64_t _keyOffset;
+	uint64_t _valOffset;
+};
+
+template<class T>
+class snapshot_vector {
+public:
+	static_assert(std::is_trivially_copyable_v<T>, "snapshot_vector requires a trivially copyable type");
+
+	snapshot_vector() = default;
+
+	bool empty() const;
+	size_t size() const;
+	const T* data() const;
+	const T& operator[](size_t idx) const;
+	const T* begin() const;
+	const T* end() const;
+
+	bool isPromoted() const;
+	MultiCore::vector<T>& edit();
+
+private:
+	friend class snapshot_reader;
+
+	std::shared_ptr<const mapped_file> _pFile;
+	const T* _pData = nullptr;
+	size_t _size = 0;
+	std::shared_ptr<MultiCore::vector<T>> _pOwned;
+};
+
+template<class T>
+class snapshot_set {
+public:
+	static_assert(std::is_trivially_copyable_v<T>, "snapshot_set requires a trivially copyable type");
+
+	snapshot_set() = default;
+
+	bool empty() const;
+	size_t size() const;
+	const T* begin() const;
+	const T* end() const;
+
+	const T* find(const T& val) const;
+	bool contains(const T& val) const;
+	size_t count(const T& val) const;
+
+	bool isPromoted() const;
+	MultiCore::set<T>& edit();
+
+private:
+	friend class snapshot_reader;
+
+	std::shared_ptr<const mapped_file> _pFile;
+	const T* _pData = nullptr;
+	size_t _size = 0;
+	std::shared_ptr<MultiCore::set<T>> _pOwned;
+};
+
+template<class KEY, class T>
+class snapshot_map {
+public:
+	static_assert(std::is_trivially_copyable_v<KEY>, "snapshot_map requires a trivially copyable key");
+	static_assert(std::is_trivially_copyable_v<T>, "snapshot_map requires a trivially copyable value");
+
+	snapshot_map() = default;
+
+	bool empty() const;
+	size_t size() const;
+
+	// Entries are in key order
+	const KEY& keyAt(size_t idx) const;
+	const T& valueAt(size_t idx) const;
+
+	// Returns nullptr if the key is not present
+	const T* find(const KEY& key) const;
+	bool contains(const KEY& key) const;
+	size_t count(const KEY& key) const;
+
+	bool isPromoted() const;
+	MultiCore::map<KEY, T>& edit();
+
+private:
+	friend class snapshot_reader;
+
+	std::shared_ptr<const mapped_file> _pFile;
+	const KEY* _pKeys = nullptr;
+	const T* _pVals = nullptr;
+	size_t _size = 0;
+	std::shared_ptr<MultiCore::map<KEY, T>> _pOwned;
+};
+
+class snapshot_writer {
+public:
+	snapshot_writer() = default;
+	~snapshot_writer();
+
+	bool open(const std::string& path);
+	// Writes the directory and header. Returns false if any write failed.
+	bool close();
+
+	// Each add returns the entry number used to read the container back, or -1 on failure
+	template<class T>
+	size_t add(const MultiCore::vector<T>& src);
+	template<class T>
+	size_t add(const MultiCore::set<T>& src);
+	template<class KEY, class T>
+	size_t add(const MultiCore::map<KEY, T>& src);
+
+private:
+	uint64_t writeArray(const void* pData, size_t numBytes);
+	uint64_t alignOutput();
+
+	std::ofstream _out;
+	std::vector<snapshot_entry> _entries;
+};
+
+class snapshot_reader {
+public:
+	snapshot_reader() = default;
+
+	bool open(const std::string& path);
+	void close();
+
+	size_t getNumEntries() const;
+
+	template<class T>
+	bool get(size_t entryNum, snapshot_vector<T>& result) const;
+	template<class T>
+	bool get(size_t entryNum, snapshot_set<T>& result) const;
+	template<class KEY, class T>
+	bool get(size_t entryNum, snapshot_map<KEY, T>& result) const;
+
+private:
+	const snapshot_entry* getEntry(size_t entryNum, uint32_t kind, size_t keySize, size_t valSize) const;
+	bool isRangeValid(uint64_t offset, size_t numBytes) const;
+
+	std::shared_ptr<mapped_file> _pFile;
+	const snapshot_entry* _pEntries = nullptr;
+	size_t _numEntries = 0;
+};
+
+}
+
+#include <pool_snapshot.hpp>
@@ -0,0 +1,363 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <pool_snapshot.h>
+
+namespace MultiCore {
+
+template<class T>
+inline bool snapshot_vector<T>::empty() const
+{
+	return size() == 0;
+}
+
+template<class T>
+inline size_t snapshot_vector<T>::size() const
+{
+	return _pOwned ? _pOwned->size() : _size;
+}
+
+template<class T>
+inline const T* snapshot_vector<T>::data() const
+{
+	return _pOwned ? _pOwned->data() : _pData;
+}
+
+template<class T>
+inline const T& snapshot_vector<T>::operator[](size_t idx) const
+{
+	return data()[idx];
+}
+
+template<class T>
+inline const T* snapshot_vector<T>::begin() const
+{
+	return data();
+}
+
+template<class T>
+inline const T* snapshot_vector<T>::end() const
+{
+	return data() + size();
+}
+
+template<class T>
+inline bool snapshot_vector<T>::isPromoted() const
+{
+	return (bool)_pOwned;
+}
+
+template<class T>
+MultiCore::vector<T>& snapshot_vector<T>::edit()
+{
+	if (!_pOwned) {
+		_pOwned = std::make_shared<MultiCore::vector<T>>();
+		_pOwned->resize(_size);
+		if (_size > 0)
+			memcpy(_pOwned->data(), _pData, _size * sizeof(T));
+		_pData = nullptr;
+		_size = 0;
+		_pFile.reset();
+	}
+	return *_pOwned;
+}
+
+/*************************************************************************************************/
+
+template<class T>
+inline bool snapshot_set<T>::empty() const
+{
+	return size() == 0;
+}
+
+template<class T>
+inline size_t snapshot_set<T>::size() const
+{
+	return _pOwned ? _pOwned->size() : _size;
+}
+
+template<class T>
+inline const T* snapshot_set<T>::begin() const
+{
+	if (_pOwned)
+		return _pOwned->empty() ? nullptr : &*_pOwned->begin();
+	return _pData;
+}
+
+template<class T>
+inline const T* snapshot_set<T>::end() const
+{
+	return begin() + size();
+}
+
+template<class T>
+const T* snapshot_set<T>::find(const T& val) const
+{
+	const T* pEnd = end();
+	const T* p = std::lower_bound(begin(), pEnd, val);
+	if (p != pEnd && !(val < *p))
+		return p;
+	return nullptr;
+}
+
+template<class T>
+inline bool snapshot_set<T>::contains(const T& val) const
+{
+	return find(val) != nullptr;
+}
+
+template<class T>
+inline size_t snapshot_set<T>::count(const T& val) const
+{
+	return contains(val) ? 1 : 0;
+}
+
+template<class T>
+inline bool snapshot_set<T>::isPromoted() const
+{
+	return (bool)_pOwned;
+}
+
+template<class T>
+MultiCore::set<T>& snapshot_set<T>::edit()
+{
+	if (!_pOwned) {
+		// The image is already sorted and unique, so this is a single pass
+		_pOwned = std::make_shared<MultiCore::set<T>>();
+		_pOwned->insert_sorted(_pData, _pData + _size);
+		_pData = nullptr;
+		_size = 0;
+		_pFile.reset();
+	}
+	return *_pOwned;
+}
+
+/*************************************************************************************************/
+
+template<class KEY, class T>
+inline bool snapshot_map<KEY, T>::empty() const
+{
+	return size() == 0;
+}
+
+template<class KEY, class T>
+inline size_t snapshot_map<KEY, T>::size() const
+{
+	return _pOwned ? _pOwned->size() : _size;
+}
+
+template<class KEY, class T>
+inline const KEY& snapshot_map<KEY, T>::keyAt(size_t idx) const
+{
+	if (_pOwned)
+		return (_pOwned->begin() + idx)->first;
+	return _pKeys[idx];
+}
+
+template<class KEY, class T>
+inline const T& snapshot_map<KEY, T>::valueAt(size_t idx) const
+{
+	if (_pOwned)
+		return (_pOwned->begin() + idx)->second;
+	return _pVals[idx];
+}
+
+template<class KEY, class T>
+const T* snapshot_map<KEY, T>::find(const KEY& key) const
+{
+	if (_pOwned) {
+		const auto& owned = *_pOwned;
+		auto iter = owned.find(key);
+		return iter != owned.end() ? &iter->second : nullptr;
+	}
+
+	const KEY* p = std::lower_bound(_pKeys, _pKeys + _size, key);
+	if (p != _pKeys + _size && !(key < *p))
+		return &_pVals[p - _pKeys];
+	return nullptr;
+}
+
+template<class KEY, class T>
+inline bool snapshot_map<KEY, T>::contains(const KEY& key) const
+{
+	return find(key) != nullptr;
+}
+
+template<class KEY, class T>
+inline size_t snapshot_map<KEY, T>::count(const KEY& key) const
+{
+	return contains(key) ? 1 : 0;
+}
+
+template<class KEY, class T>
+inline bool snapshot_map<KEY, T>::isPromoted() const
+{
+	return (bool)_pOwned;
+}
+
+template<class KEY, class T>
+MultiCore::map<KEY, T>& snapshot_map<KEY, T>::edit()
+{
+	if (!_pOwned) {
+		using DataPair = typename MultiCore::map<KEY, T>::DataPair;
+
+		MultiCore::vector<DataPair> pairs;
+		pairs.reserve(_size);
+		for (size_t i = 0; i < _size; i++)
+			pairs.push_back(DataPair(_pKeys[i], _pVals[i]));
+
+		_pOwned = std::make_shared<MultiCore::map<KEY, T>>();
+		_pOwned->insert_sorted(pairs.data(), pairs.data() + pairs.size());
+		_pKeys = nullptr;
+		_pVals = nullptr;
+		_size = 0;
+		_pFile.reset();
+	}
+	return *_pOwned;
+}
+
+/*************************************************************************************************/
+
+template<class T>
+size_t snapshot_writer::add(const MultiCore::vector<T>& src)
+{
+	static_assert(std::is_trivially_copyable_v<T>, "snapshots require a trivially copyable type");
+
+	snapshot_entry entry;
+	entry._kind = snapshot_entry::KIND_VECTOR;
+	entry._keySize = 0;
+	entry._valSize = (uint32_t)sizeof(T);
+	entry._count = src.size();
+	entry._keyOffset = 0;
+	entry._valOffset = writeArray(src.data(), src.size() * sizeof(T));
+	if (entry._valOffset == 0)
+		return -1;
+
+	_entries.push_back(entry);
+	return _entries.size() - 1;
+}
+
+template<class T>
+size_t snapshot_writer::add(const MultiCore::set<T>& src)
+{
+	static_assert(std::is_trivially_copyable_v<T>, "snapshots require a trivially copyable type");
+
+	// set storage is one contiguous sorted array
+	snapshot_entry entry;
+	entry._kind = snapshot_entry::KIND_SET;
+	entry._keySize = (uint32_t)sizeof(T);
+	entry._valSize = 0;
+	entry._count = src.size();
+	entry._keyOffset = writeArray(src.empty() ? nullptr : &*src.begin(), src.size() * sizeof(T));
+	entry._valOffset = 0;
+	if (entry._keyOffset == 0)
+		return -1;
+
+	_entries.push_back(entry);
+	return _entries.size() - 1;
+}
+
+template<class KEY, class T>
+size_t snapshot_writer::add(const MultiCore::map<KEY, T>& src)
+{
+	static_assert(std::is_trivially_copyable_v<KEY>, "snapshots require a trivially copyable key");
+	static_assert(std::is_trivially_copyable_v<T>, "snapshots require a trivially copyable value");
+
+	if (!_out.is_open())
+		return -1;
+
+	snapshot_entry entry;
+	entry._kind = snapshot_entry::KIND_MAP;
+	entry._keySize = (uint32_t)sizeof(KEY);
+	entry._valSize = (uint32_t)sizeof(T);
+	entry._count = src.size();
+
+	// Map entries are scattered in _data, so stream the keys and values out in key order
+	entry._keyOffset = alignOutput();
+	for (const auto& pair : src)
+		_out.write((const char*)&pair.first, sizeof(KEY));
+	entry._valOffset = alignOutput();
+	for (const auto& pair : src)
+		_out.write((const char*)&pair.second, sizeof(T));
+
+	if (!_out.good())
+		return -1;
+
+	_entries.push_back(entry);
+	return _entries.size() - 1;
+}
+
+/*************************************************************************************************/
+
+template<class T>
+bool snapshot_reader::get(size_t entryNum, snapshot_vector<T>& result) const
+{
+	const snapshot_entry* pEntry = getEntry(entryNum, snapshot_entry::KIND_VECTOR, 0, sizeof(T));
+	if (!pEntry)
+		return false;
+
+	result = snapshot_vector<T>();
+	result._pFile = _pFile;
+	result._pData = (const T*)(_pFile->data() + pEntry->_valOffset);
+	result._size = (size_t)pEntry->_count;
+	return true;
+}
+
+template<class T>
+bool snapshot_reader::get(size_t entryNum, snapshot_set<T>& result) const
+{
+	const snapshot_entry* pEntry = getEntry(entryNum, snapshot_entry::KIND_SET, sizeof(T), 0);
+	if (!pEntry)
+		return false;
+
+	result = snapshot_set<T>();
+	result._pFile = _pFile;
+	result._pData = (const T*)(_pFile->data() + pEntry->_keyOffset);
+	result._size = (size_t)pEntry->_count;
+	return true;
+}
+
+template<class KEY, class T>
+bool snapshot_reader::get(size_t entryNum, snapshot_map<KEY, T>& result) const
+{
+	const snapshot_entry* pEntry = getEntry(entryNum, snapshot_entry::KIND_MAP, sizeof(KEY), sizeof(T));
+	if (!pEntry)
+		return false;
+
+	result = snapshot_map<KEY, T>();
+	result._pFile = _pFile;
+	result._pKeys = (const KEY*)(_pFile->data() + pEntry->_keyOffset);
+	result._pVals = (const T*)(_pFile->data() + pEntry->_valOffset);
+	result._size = (size_t)pEntry->_count;
+	return true;
+}
+
+}
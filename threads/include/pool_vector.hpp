@@ -122,6 +122,8 @@ void VECTOR_DECL::resize(size_t val)
 	size_t needed = val;
 	if (needed < 8)
 		needed = 8;
+	if (needed > _capacity && needed < _capacity + _capacity / 2)
+		needed = _capacity + _capacity / 2; // Grow the same as push_back. Growing by one made every insert a reallocation.
 	reserve(needed);
 	_size = val;
 }
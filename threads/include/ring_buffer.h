@@ -0,0 +1,121 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <atomic>
+#include <local_heap.h>
+
+#define RING_BUFFER_CACHE_LINE 64
+
+namespace MultiCore
+{
+
+/*
+	Growable ring buffer with O(1) push and pop at both ends, a deque for work queues and pipelines.
+	Storage is one power of 2 array from the local_heap, indices wrap with a mask. Growing doubles the array and
+	unwraps the contents. Not thread safe, guard it like any other MultiCore container.
+*/
+
+template<class T>
+class ring_buffer : private local_heap_user {
+public:
+	ring_buffer() = default;
+	ring_buffer(const ring_buffer& src);
+	~ring_buffer();
+
+	ring_buffer& operator = (const ring_buffer& rhs);
+
+	void clear();
+	bool empty() const;
+	size_t size() const;
+	size_t capacity() const;
+	void reserve(size_t val);
+
+	void push_back(const T& val);
+	void push_front(const T& val);
+	void pop_back();
+	void pop_front();
+
+	const T& front() const;
+	T& front();
+	const T& back() const;
+	T& back();
+
+	// idx 0 is the front
+	const T& operator[](size_t idx) const;
+	T& operator[](size_t idx);
+
+private:
+	void grow();
+	void resetEntry(size_t slot);
+
+	size_t _head = 0, _size = 0, _capacity = 0;
+	T* _pData = nullptr;
+};
+
+/*
+	Bounded single producer/single consumer ring buffer. One thread may call try_push and one other thread may call
+	try_pop with no locks. The head and tail indices are on separate cache lines and each side caches its last view of
+	the other's index, so the shared lines are only read when the buffer looks full or empty.
+	The buffer is allocated from the constructing thread's local_heap.
+*/
+
+template<class T>
+class spsc_ring_buffer : private local_heap_user {
+public:
+	spsc_ring_buffer(size_t capacity);
+	spsc_ring_buffer(const spsc_ring_buffer& src) = delete;
+	~spsc_ring_buffer();
+
+	spsc_ring_buffer& operator = (const spsc_ring_buffer& rhs) = delete;
+
+	// Producer thread only
+	bool try_push(const T& val);
+
+	// Consumer thread only
+	bool try_pop(T& val);
+
+	// Approximate when called while the other side is active
+	size_t size() const;
+	bool empty() const;
+	size_t capacity() const;
+
+private:
+	const size_t _capacity;
+	const size_t _mask;
+	T* _pData = nullptr;
+
+	alignas(RING_BUFFER_CACHE_LINE) _STD atomic<size_t> _head = 0; // Next slot to pop, written by the consumer
+	size_t _cachedTail = 0;
+
+	alignas(RING_BUFFER_CACHE_LINE) _STD atomic<size_t> _tail = 0; // Next slot to push, written by the producer
+	size_t _cachedHead = 0;
+};
+
+}
+
+#include <ring_buffer.hpp>
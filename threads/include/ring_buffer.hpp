@@ -0,0 +1,282 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <assert.h>
+#include <bit>
+#include <utility>
+#include <ring_buffer.h>
+
+#define TEMPL_DECL template<class T> 
+#define RING_DECL ring_buffer<T> 
+#define SPSC_DECL spsc_ring_buffer<T> 
+
+namespace MultiCore {
+
+TEMPL_DECL
+RING_DECL::ring_buffer(const ring_buffer& src)
+{
+	*this = src;
+}
+
+TEMPL_DECL
+RING_DECL::~ring_buffer()
+{
+	free(_pData); // free<T> will handle destruction for each object in local_heap
+}
+
+TEMPL_DECL
+MultiCore::ring_buffer<T>& RING_DECL::operator = (const ring_buffer& rhs)
+{
+	if (this == &rhs)
+		return *this;
+
+	clear();
+	reserve(rhs._size);
+	for (size_t i = 0; i < rhs._size; i++)
+		push_back(rhs[i]);
+
+	return *this;
+}
+
+TEMPL_DECL
+void RING_DECL::resetEntry(size_t slot)
+{
+	// Use destructor/constructor to get around const members, same as vector::clear
+	_pData[slot].~T();
+	new(&_pData[slot]) T();
+}
+
+TEMPL_DECL
+void RING_DECL::clear()
+{
+	for (size_t i = 0; i < _size; i++)
+		resetEntry((_head + i) & (_capacity - 1));
+	_head = 0;
+	_size = 0;
+}
+
+TEMPL_DECL
+inline bool RING_DECL::empty() const
+{
+	return _size == 0;
+}
+
+TEMPL_DECL
+inline size_t RING_DECL::size() const
+{
+	return _size;
+}
+
+TEMPL_DECL
+inline size_t RING_DECL::capacity() const
+{
+	return _capacity;
+}
+
+TEMPL_DECL
+void RING_DECL::reserve(size_t val)
+{
+	if (val <= _capacity)
+		return;
+
+	size_t newCapacity = _STD bit_ceil(val < 8 ? (size_t)8 : val);
+	T* pTmp = _pData;
+	_pData = alloc<T>(newCapacity);
+	if (pTmp) {
+		// Unwrap so the front lands at slot 0
+		for (size_t i = 0; i < _size; i++) {
+			T& src = pTmp[(_head + i) & (_capacity - 1)];
+			_pData[i].~T();
+			new(&_pData[i]) T(src);
+		}
+		free(pTmp);
+	}
+	_head = 0;
+	_capacity = newCapacity;
+}
+
+TEMPL_DECL
+inline void RING_DECL::grow()
+{
+	reserve(_capacity == 0 ? 8 : 2 * _capacity);
+}
+
+TEMPL_DECL
+void RING_DECL::push_back(const T& val)
+{
+	if (_size == _capacity)
+		grow();
+
+	T* p = &_pData[(_head + _size) & (_capacity - 1)];
+	p->~T();
+	new(p) T(val);
+	_size++;
+}
+
+TEMPL_DECL
+void RING_DECL::push_front(const T& val)
+{
+	if (_size == _capacity)
+		grow();
+
+	_head = (_head + _capacity - 1) & (_capacity - 1);
+	T* p = &_pData[_head];
+	p->~T();
+	new(p) T(val);
+	_size++;
+}
+
+TEMPL_DECL
+void RING_DECL::pop_back()
+{
+	assert(_size > 0);
+	_size--;
+	resetEntry((_head + _size) & (_capacity - 1));
+}
+
+TEMPL_DECL
+void RING_DECL::pop_front()
+{
+	assert(_size > 0);
+	resetEntry(_head);
+	_head = (_head + 1) & (_capacity - 1);
+	_size--;
+}
+
+TEMPL_DECL
+inline const T& RING_DECL::front() const
+{
+	return _pData[_head];
+}
+
+TEMPL_DECL
+inline T& RING_DECL::front()
+{
+	return _pData[_head];
+}
+
+TEMPL_DECL
+inline const T& RING_DECL::back() const
+{
+	return _pData[(_head + _size - 1) & (_capacity - 1)];
+}
+
+TEMPL_DECL
+inline T& RING_DECL::back()
+{
+	return _pData[(_head + _size - 1) & (_capacity - 1)];
+}
+
+TEMPL_DECL
+inline const T& RING_DECL::operator[](size_t idx) const
+{
+	return _pData[(_head + idx) & (_capacity - 1)];
+}
+
+TEMPL_DECL
+inline T& RING_DECL::operator[](size_t idx)
+{
+	return _pData[(_head + idx) & (_capacity - 1)];
+}
+
+/*************************************************************************************************/
+/*************************************************************************************************/
+/*************************************************************************************************/
+
+TEMPL_DECL
+SPSC_DECL::spsc_ring_buffer(size_t capacity)
+	: _capacity(_STD bit_ceil(capacity < 2 ? (size_t)2 : capacity))
+	, _mask(_capacity - 1)
+{
+	_pData = alloc<T>(_capacity);
+}
+
+TEMPL_DECL
+SPSC_DECL::~spsc_ring_buffer()
+{
+	free(_pData);
+}
+
+TEMPL_DECL
+bool SPSC_DECL::try_push(const T& val)
+{
+	// _tail and _head are free running counters, only the slot index is masked
+	const size_t tail = _tail.load(_STD memory_order_relaxed);
+	if (tail - _cachedHead == _capacity) {
+		_cachedHead = _head.load(_STD memory_order_acquire);
+		if (tail - _cachedHead == _capacity)
+			return false;
+	}
+
+	_pData[tail & _mask] = val;
+	_tail.store(tail + 1, _STD memory_order_release);
+	return true;
+}
+
+TEMPL_DECL
+bool SPSC_DECL::try_pop(T& val)
+{
+	const size_t head = _head.load(_STD memory_order_relaxed);
+	if (head == _cachedTail) {
+		_cachedTail = _tail.load(_STD memory_order_acquire);
+		if (head == _cachedTail)
+			return false;
+	}
+
+	// Move out and reset the slot, same as ring_buffer's pops, so what it owned doesn't live on until it's overwritten
+	T* pEntry = &_pData[head & _mask];
+	val = _STD move(*pEntry);
+	pEntry->~T();
+	new(pEntry) T();
+	_head.store(head + 1, _STD memory_order_release);
+	return true;
+}
+
+TEMPL_DECL
+inline size_t SPSC_DECL::size() const
+{
+	return _tail.load(_STD memory_order_acquire) - _head.load(_STD memory_order_acquire);
+}
+
+TEMPL_DECL
+inline bool SPSC_DECL::empty() const
+{
+	return size() == 0;
+}
+
+TEMPL_DECL
+inline size_t SPSC_DECL::capacity() const
+{
+	return _capacity;
+}
+
+}
+
+#undef TEMPL_DECL
+#undef RING_DECL
+#undef SPSC_DECL
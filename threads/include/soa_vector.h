@@ -0,0 +1,187 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <span>
+#include <tuple>
+#include <utility>
+#include <local_heap.h>
+
+#define SOA_ALIGNMENT 64
+
+namespace MultiCore
+{
+
+/*
+	Struct of arrays vector. soa_vector<float, float, float> stores x, y and z each in its own SOA_ALIGNMENT aligned array
+	in the local_heap, so a kernel which only reads x streams x and nothing else and SIMD loops get aligned loads.
+
+	Rows are accessed through a proxy holding the index, v[i].get<0>() or v.get<0>(i). field<I>() returns a span over one
+	column which can be handed to a SIMD loop or to glBufferData(target, v.fieldBytes<I>(), v.data<I>(), usage).
+
+	Like MultiCore::vector, every entry up to the capacity is default constructed, so all field types must be default
+	constructible. Growing invalidates field pointers and spans.
+*/
+
+template<class... Ts>
+class soa_vector : private local_heap_user {
+public:
+	static constexpr size_t NUM_FIELDS = sizeof...(Ts);
+	using value_type = _STD tuple<Ts...>;
+
+	template<size_t I>
+	using field_type = _STD tuple_element_t<I, value_type>;
+
+protected:
+	template <bool IsConst>
+	class _row
+	{
+	public:
+		using source = _STD conditional_t<IsConst, const soa_vector, soa_vector>;
+
+		_row(source* pSource, size_t idx);
+
+		template<size_t I>
+		_STD conditional_t<IsConst, const field_type<I>&, field_type<I>&> get() const;
+
+		operator value_type() const;
+		const _row& operator = (const value_type& rhs) const;
+
+	private:
+		template<size_t... Is>
+		value_type toTuple(_STD index_sequence<Is...>) const;
+
+		source* _pSource;
+		size_t _idx;
+	};
+
+	template <bool IsConst>
+	class _iterator
+	{
+	public:
+		using iterator_category = _STD random_access_iterator_tag;
+		using difference_type = _STD ptrdiff_t;
+		using source = _STD conditional_t<IsConst, const soa_vector, soa_vector>;
+
+		_iterator() = default;
+		_iterator(source* pSource, size_t idx);
+		_iterator(const _iterator& src) = default;
+
+		bool operator == (const _iterator& rhs) const;
+		bool operator != (const _iterator& rhs) const;
+		bool operator < (const _iterator& rhs) const;
+
+		_iterator& operator ++ ();
+		_iterator& operator --();
+		_iterator operator ++ (int);
+		_iterator operator --(int);
+
+		_iterator operator + (size_t val) const;
+		_iterator operator - (size_t val) const;
+		size_t operator - (const _iterator& rhs) const;
+
+		_row<IsConst> operator *() const;
+
+	private:
+		source* _pSource = nullptr;
+		size_t _idx = 0;
+	};
+
+public:
+	using reference = _row<false>;
+	using const_reference = _row<true>;
+	using iterator = _iterator<false>;
+	using const_iterator = _iterator<true>;
+
+	soa_vector();
+	soa_vector(const soa_vector& src);
+	~soa_vector();
+
+	soa_vector& operator = (const soa_vector& rhs);
+
+	void clear();
+	bool empty() const;
+	size_t size() const;
+	size_t capacity() const;
+	void resize(size_t val);
+	void reserve(size_t val);
+
+	size_t push_back(const Ts&... vals);
+	size_t push_back(const value_type& val);
+	void pop_back();
+
+	const_reference operator[](size_t idx) const;
+	reference operator[](size_t idx);
+
+	template<size_t I>
+	const field_type<I>& get(size_t idx) const;
+	template<size_t I>
+	field_type<I>& get(size_t idx);
+
+	template<size_t I>
+	const field_type<I>* data() const;
+	template<size_t I>
+	field_type<I>* data();
+
+	template<size_t I>
+	_STD span<const field_type<I>> field() const;
+	template<size_t I>
+	_STD span<field_type<I>> field();
+
+	template<size_t I>
+	size_t fieldBytes() const;
+
+	const_iterator begin() const noexcept;
+	iterator begin() noexcept;
+	const_iterator end() const noexcept;
+	iterator end() noexcept;
+
+private:
+	using Indices = _STD index_sequence_for<Ts...>;
+
+	template<size_t I>
+	void allocField(size_t capacity, _STD tuple<Ts*...>& fields, char** pRaw);
+	template<size_t I>
+	void freeField(_STD tuple<Ts*...>& fields, char** pRaw, size_t capacity);
+
+	template<size_t... Is>
+	void reallocate(size_t newCapacity, _STD index_sequence<Is...>);
+	template<size_t... Is>
+	void freeAll(_STD index_sequence<Is...>);
+	template<size_t... Is>
+	void resetEntry(size_t idx, _STD index_sequence<Is...>);
+	template<size_t... Is>
+	void setEntry(size_t idx, const value_type& val, _STD index_sequence<Is...>);
+
+	size_t _size = 0, _capacity = 0;
+	_STD tuple<Ts*...> _fields;
+	char* _pRaw[NUM_FIELDS];
+};
+
+}
+
+#include <soa_vector.hpp>
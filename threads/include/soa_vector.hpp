@@ -0,0 +1,464 @@
+#pragma once
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <assert.h>
+#include <soa_vector.h>
+
+#define TEMPL_DECL template<class... Ts> 
+#define ITER_TEMPL_DECL template <bool IsConst>
+#define SOA_DECL soa_vector<Ts...> 
+#define ROW_DECL soa_vector<Ts...>::_row<IsConst>
+#define ITER_DECL soa_vector<Ts...>::_iterator<IsConst>
+#define ITER_DECL_2 soa_vector<Ts...>::template _iterator<IsConst>
+
+namespace MultiCore {
+
+TEMPL_DECL
+SOA_DECL::soa_vector()
+{
+	for (size_t i = 0; i < NUM_FIELDS; i++)
+		_pRaw[i] = nullptr;
+	_fields = {};
+}
+
+TEMPL_DECL
+SOA_DECL::soa_vector(const soa_vector& src)
+	: soa_vector()
+{
+	*this = src;
+}
+
+TEMPL_DECL
+SOA_DECL::~soa_vector()
+{
+	freeAll(Indices());
+}
+
+TEMPL_DECL
+MultiCore::soa_vector<Ts...>& SOA_DECL::operator = (const soa_vector& rhs)
+{
+	if (this == &rhs)
+		return *this;
+
+	clear();
+	reserve(rhs._size);
+	for (size_t i = 0; i < rhs._size; i++)
+		push_back((value_type)rhs[i]);
+
+	return *this;
+}
+
+TEMPL_DECL
+template<size_t I>
+void SOA_DECL::allocField(size_t capacity, _STD tuple<Ts*...>& fields, char** pRaw)
+{
+	using T = field_type<I>;
+
+	// Over allocate raw bytes from the local heap, then align the start of the column
+	pRaw[I] = alloc<char>(capacity * sizeof(T) + SOA_ALIGNMENT);
+	size_t addr = (size_t)pRaw[I];
+	addr = (addr + SOA_ALIGNMENT - 1) & ~((size_t)SOA_ALIGNMENT - 1);
+	T* p = (T*)addr;
+	for (size_t i = 0; i < capacity; i++)
+		new(&p[i]) T();
+
+	_STD get<I>(fields) = p;
+}
+
+TEMPL_DECL
+template<size_t I>
+void SOA_DECL::freeField(_STD tuple<Ts*...>& fields, char** pRaw, size_t capacity)
+{
+	using T = field_type<I>;
+
+	T*& p = _STD get<I>(fields);
+	if (p) {
+		for (size_t i = 0; i < capacity; i++)
+			p[i].~T();
+		p = nullptr;
+	}
+	free(pRaw[I]);
+}
+
+TEMPL_DECL
+template<size_t... Is>
+void SOA_DECL::reallocate(size_t newCapacity, _STD index_sequence<Is...>)
+{
+	_STD tuple<Ts*...> newFields;
+	char* pNewRaw[NUM_FIELDS];
+	(allocField<Is>(newCapacity, newFields, pNewRaw), ...);
+
+	// Column by column, so each copy is a sequential stream
+	([&] {
+		auto pSrc = _STD get<Is>(_fields);
+		auto pDst = _STD get<Is>(newFields);
+		for (size_t i = 0; i < _size; i++)
+			pDst[i] = pSrc[i];
+	}(), ...);
+
+	freeAll(Indices());
+	_fields = newFields;
+	for (size_t i = 0; i < NUM_FIELDS; i++)
+		_pRaw[i] = pNewRaw[i];
+	_capacity = newCapacity;
+}
+
+TEMPL_DECL
+template<size_t... Is>
+void SOA_DECL::freeAll(_STD index_sequence<Is...>)
+{
+	if (_capacity == 0)
+		return;
+	(freeField<Is>(_fields, _pRaw, _capacity), ...);
+}
+
+TEMPL_DECL
+template<size_t... Is>
+void SOA_DECL::resetEntry(size_t idx, _STD index_sequence<Is...>)
+{
+	// Use destructor/constructor to get around const members, same as vector::clear
+	([&] {
+		using T = field_type<Is>;
+		T* p = &_STD get<Is>(_fields)[idx];
+		p->~T();
+		new(p) T();
+	}(), ...);
+}
+
+TEMPL_DECL
+template<size_t... Is>
+void SOA_DECL::setEntry(size_t idx, const value_type& val, _STD index_sequence<Is...>)
+{
+	((_STD get<Is>(_fields)[idx] = _STD get<Is>(val)), ...);
+}
+
+TEMPL_DECL
+void SOA_DECL::clear()
+{
+	for (size_t i = 0; i < _size; i++)
+		resetEntry(i, Indices());
+	_size = 0;
+}
+
+TEMPL_DECL
+inline bool SOA_DECL::empty() const
+{
+	return _size == 0;
+}
+
+TEMPL_DECL
+inline size_t SOA_DECL::size() const
+{
+	return _size;
+}
+
+TEMPL_DECL
+inline size_t SOA_DECL::capacity() const
+{
+	return _capacity;
+}
+
+TEMPL_DECL
+void SOA_DECL::resize(size_t val)
+{
+	reserve(val);
+	for (size_t i = val; i < _size; i++)
+		resetEntry(i, Indices());
+	_size = val;
+}
+
+TEMPL_DECL
+void SOA_DECL::reserve(size_t newCapacity)
+{
+	if (newCapacity > _capacity)
+		reallocate(newCapacity, Indices());
+}
+
+TEMPL_DECL
+inline size_t SOA_DECL::push_back(const Ts&... vals)
+{
+	return push_back(value_type(vals...));
+}
+
+TEMPL_DECL
+size_t SOA_DECL::push_back(const value_type& val)
+{
+	if (_size + 1 > _capacity) {
+		size_t newCapacity = _capacity;
+		if (newCapacity == 0)
+			newCapacity = 8;
+		else
+			newCapacity += newCapacity / 2;
+
+		reserve(newCapacity);
+	}
+
+	setEntry(_size, val, Indices());
+	_size += 1;
+
+	return _size;
+}
+
+TEMPL_DECL
+void SOA_DECL::pop_back()
+{
+	assert(_size > 0);
+	_size--;
+	resetEntry(_size, Indices());
+}
+
+TEMPL_DECL
+inline typename SOA_DECL::const_reference SOA_DECL::operator[](size_t idx) const
+{
+	return const_reference(this, idx);
+}
+
+TEMPL_DECL
+inline typename SOA_DECL::reference SOA_DECL::operator[](size_t idx)
+{
+	return reference(this, idx);
+}
+
+TEMPL_DECL
+template<size_t I>
+inline const typename SOA_DECL::template field_type<I>& SOA_DECL::get(size_t idx) const
+{
+	return _STD get<I>(_fields)[idx];
+}
+
+TEMPL_DECL
+template<size_t I>
+inline typename SOA_DECL::template field_type<I>& SOA_DECL::get(size_t idx)
+{
+	return _STD get<I>(_fields)[idx];
+}
+
+TEMPL_DECL
+template<size_t I>
+inline const typename SOA_DECL::template field_type<I>* SOA_DECL::data() const
+{
+	return _STD get<I>(_fields);
+}
+
+TEMPL_DECL
+template<size_t I>
+inline typename SOA_DECL::template field_type<I>* SOA_DECL::data()
+{
+	return _STD get<I>(_fields);
+}
+
+TEMPL_DECL
+template<size_t I>
+inline _STD span<const typename SOA_DECL::template field_type<I>> SOA_DECL::field() const
+{
+	return _STD span<const field_type<I>>(data<I>(), _size);
+}
+
+TEMPL_DECL
+template<size_t I>
+inline _STD span<typename SOA_DECL::template field_type<I>> SOA_DECL::field()
+{
+	return _STD span<field_type<I>>(data<I>(), _size);
+}
+
+TEMPL_DECL
+template<size_t I>
+inline size_t SOA_DECL::fieldBytes() const
+{
+	return _size * sizeof(field_type<I>);
+}
+
+TEMPL_DECL
+inline typename SOA_DECL::const_iterator SOA_DECL::begin() const noexcept
+{
+	return const_iterator(this, 0);
+}
+
+TEMPL_DECL
+inline typename SOA_DECL::iterator SOA_DECL::begin() noexcept
+{
+	return iterator(this, 0);
+}
+
+TEMPL_DECL
+inline typename SOA_DECL::const_iterator SOA_DECL::end() const noexcept
+{
+	return const_iterator(this, _size);
+}
+
+TEMPL_DECL
+inline typename SOA_DECL::iterator SOA_DECL::end() noexcept
+{
+	return iterator(this, _size);
+}
+
+/*************************************************************************************************/
+/*************************************************************************************************/
+/*************************************************************************************************/
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline ROW_DECL::_row(source* pSource, size_t idx)
+	: _pSource(pSource)
+	, _idx(idx)
+{
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+template<size_t I>
+inline _STD conditional_t<IsConst, const typename SOA_DECL::template field_type<I>&, typename SOA_DECL::template field_type<I>&> ROW_DECL::get() const
+{
+	return _pSource->template get<I>(_idx);
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline ROW_DECL::operator value_type() const
+{
+	return toTuple(Indices());
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+template<size_t... Is>
+inline typename SOA_DECL::value_type ROW_DECL::toTuple(_STD index_sequence<Is...>) const
+{
+	return value_type(_pSource->template get<Is>(_idx)...);
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline const typename SOA_DECL::template _row<IsConst>& ROW_DECL::operator = (const value_type& rhs) const
+{
+	static_assert(!IsConst, "Cannot assign through a const row");
+	_pSource->setEntry(_idx, rhs, Indices());
+	return *this;
+}
+
+/*************************************************************************************************/
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline ITER_DECL::_iterator(source* pSource, size_t idx)
+	: _pSource(pSource)
+	, _idx(idx)
+{
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline bool ITER_DECL::operator == (const _iterator& rhs) const
+{
+	return _idx == rhs._idx;
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline bool ITER_DECL::operator != (const _iterator& rhs) const
+{
+	return _idx != rhs._idx;
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline bool ITER_DECL::operator < (const _iterator& rhs) const
+{
+	return _idx < rhs._idx;
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline typename ITER_DECL_2& ITER_DECL::operator ++ ()
+{
+	_idx++;
+	return *this;
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline typename ITER_DECL_2& ITER_DECL::operator --()
+{
+	_idx--;
+	return *this;
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline typename ITER_DECL_2 ITER_DECL::operator ++ (int)
+{
+	_iterator tmp(*this);
+	++*this;
+	return tmp;
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline typename ITER_DECL_2 ITER_DECL::operator --(int)
+{
+	_iterator tmp(*this);
+	--*this;
+	return tmp;
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline typename ITER_DECL_2 ITER_DECL::operator + (size_t val) const
+{
+	return _iterator(_pSource, _idx + val);
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline typename ITER_DECL_2 ITER_DECL::operator - (size_t val) const
+{
+	return _iterator(_pSource, _idx - val);
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline size_t ITER_DECL::operator - (const _iterator& rhs) const
+{
+	return _idx - rhs._idx;
+}
+
+TEMPL_DECL
+ITER_TEMPL_DECL
+inline typename SOA_DECL::template _row<IsConst> ITER_DECL::operator *() const
+{
+	return _row<IsConst>(_pSource, _idx);
+}
+
+}
+
+#undef TEMPL_DECL
+#undef ITER_TEMPL_DECL
+#undef SOA_DECL
+#undef ROW_DECL
+#undef ITER_DECL
+#undef ITER_DECL_2
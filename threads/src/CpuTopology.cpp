@@ -0,0 +1,229 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Copyright Robert R Tipton, 2022, all rights reserved except those granted in prior license statement.
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <CpuTopology.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+using namespace MultiCore;
+
+namespace
+{
+
+bool readInt(const string& path, int& val)
+{
+	ifstream in(path);
+	return (bool)(in >> val);
+}
+
+// Parses a sysfs CPU list, "0-3,8,10-11"
+vector<int> readCpuList(const string& path)
+{
+	vector<int> result;
+	ifstream in(path);
+	string text;
+	if (!getline(in, text))
+		return result;
+
+	stringstream ss(text);
+	string range;
+	while (getline(ss, range, ',')) {
+		int first, last;
+		char dash;
+		stringstream rs(range);
+		if (!(rs >> first))
+			continue;
+		last = first;
+		if (rs >> dash)
+			rs >> last;
+		for (int cpu = first; cpu <= last; cpu++)
+			result.push_back(cpu);
+	}
+	return result;
+}
+
+}
+
+const CpuTopology& CpuTopology::get()
+{
+	static const CpuTopology topology;
+	return topology;
+}
+
+CpuTopology::CpuTopology()
+{
+	discover();
+	if (_cpus.empty())
+		discoverFallback();
+
+	set<int> cores, sockets, l3Domains;
+	for (const auto& info : _cpus) {
+		cores.insert(info._core);
+		sockets.insert(info._socket);
+		l3Domains.insert(info._l3Domain);
+	}
+	_numPhysicalCores = cores.size();
+	_numSockets = sockets.size();
+	_numL3Domains = l3Domains.size();
+}
+
+void CpuTopology::discover()
+{
+#if defined(__linux__)
+	cpu_set_t mask;
+	CPU_ZERO(&mask);
+	if (sched_getaffinity(0, sizeof(mask), &mask) != 0)
+		return;
+
+	// Core ids are only unique within a package, number them (package, core_id) in order of appearance
+	map<pair<int, int>, int> coreNumbers;
+	map<int, int> siblingsSeen;
+	const string root = "/sys/devices/system/cpu/cpu";
+	for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (!CPU_ISSET(cpu, &mask))
+			continue;
+
+		const string dir = root + to_string(cpu);
+		CpuInfo info;
+		info._cpu = cpu;
+		int coreId = cpu;
+		if (!readInt(dir + "/topology/physical_package_id", info._socket) || !readInt(dir + "/topology/core_id", coreId)) {
+			_cpus.clear();
+			return;
+		}
+
+		auto key = make_pair(info._socket, coreId);
+		auto iter = coreNumbers.find(key);
+		if (iter == coreNumbers.end())
+			iter = coreNumbers.insert(make_pair(key, (int)coreNumbers.size())).first;
+		info._core = iter->second;
+		info._smtIndex = siblingsSeen[info._core]++;
+
+		info._l3Domain = -1;
+		for (int index = 0; index < 16; index++) {
+			int level;
+			const string cacheDir = dir + "/cache/index" + to_string(index);
+			if (!readInt(cacheDir + "/level", level))
+				break;
+			if (level == 3) {
+				auto shared = readCpuList(cacheDir + "/shared_cpu_list");
+				if (!shared.empty())
+					info._l3Domain = *min_element(shared.begin(), shared.end());
+			}
+		}
+		if (info._l3Domain == -1)
+			info._l3Domain = info._socket; // No L3 reported, treat the package as the domain
+
+		_cpus.push_back(info);
+	}
+#endif
+}
+
+void CpuTopology::discoverFallback()
+{
+	int num = max((int)thread::hardware_concurrency(), 1);
+	for (int cpu = 0; cpu < num; cpu++) {
+		CpuInfo info;
+		info._cpu = cpu;
+		info._core = cpu;
+		_cpus.push_back(info);
+	}
+}
+
+vector<CpuInfo> CpuTopology::selectCpus(const PlacementOptions& options) const
+{
+	// Bucket the usable CPUs by (socket, L3), lowest SMT index first, then deal from the buckets in turn
+	map<pair<int, int>, vector<CpuInfo>> buckets;
+	for (const auto& info : _cpus) {
+		if (find(options._reservedCpus.begin(), options._reservedCpus.end(), info._cpu) != options._reservedCpus.end())
+			continue;
+		if (options._skipSmtSiblings && info._smtIndex != 0)
+			continue;
+		buckets[make_pair(info._socket, info._l3Domain)].push_back(info);
+	}
+
+	for (auto& bucket : buckets) {
+		stable_sort(bucket.second.begin(), bucket.second.end(), [](const CpuInfo& lhs, const CpuInfo& rhs) {
+			return lhs._smtIndex < rhs._smtIndex;
+		});
+	}
+
+	vector<CpuInfo> result;
+	for (size_t i = 0; ; i++) {
+		bool added = false;
+		for (auto& bucket : buckets) {
+			if (i < bucket.second.size()) {
+				result.push_back(bucket.second[i]);
+				added = true;
+			}
+		}
+		if (!added)
+			break;
+	}
+	return result;
+}
+
+string CpuTopology::report() const
+{
+	stringstream ss;
+	ss << _cpus.size() << " logical cpus, " << _numPhysicalCores << " cores, " << _numSockets << " sockets, " << _numL3Domains << " L3 domains\n";
+	for (const auto& info : _cpus) {
+		ss << "cpu " << info._cpu << ": socket " << info._socket << " core " << info._core << " smt " << info._smtIndex
+			<< " L3 " << info._l3Domain << "\n";
+	}
+	return ss.str();
+}
+
+bool CpuTopology::pinCurrentThread(int cpu)
+{
+#if defined(_WIN32)
+	if (cpu < 0 || cpu >= 64)
+		return false;
+	return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+#elif defined(__linux__)
+	if (cpu < 0 || cpu >= CPU_SETSIZE)
+		return false;
+	cpu_set_t mask;
+	CPU_ZERO(&mask);
+	CPU_SET(cpu, &mask);
+	return pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+#else
+	return false;
+#endif
+}
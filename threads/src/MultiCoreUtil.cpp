@@ -42,14 +42,23 @@
 //
 
 #include <iostream>
+#include <sstream>
 #include <thread>
 #include <mutex>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <assert.h>
 
 #if defined(_WIN32)
 #include <process.h>
 #endif
 
+#if defined(_M_X64) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 #include <algorithm>
 #include <MultiCoreUtil.h>
 
@@ -58,13 +67,251 @@
 #endif
 
 using namespace std;
+using namespace std::chrono;
 using namespace MultiCore;
 
+namespace
+{
+	mutex s_globalPoolMutex;
+	unique_ptr<ThreadPool> s_pGlobalPool;
+	atomic<ThreadPool*> s_globalPoolPtr = nullptr;
+}
+
+ThreadPool& MultiCore::getGlobalPool()
+{
+	ThreadPool* pPool = s_globalPoolPtr.load(memory_order_acquire);
+	if (pPool)
+		return *pPool;
+
+	lock_guard lg(s_globalPoolMutex);
+	if (!s_pGlobalPool) {
+		size_t numThreads = max(getNumCores(), 1);
+		s_pGlobalPool = make_unique<ThreadPool>(numThreads, numThreads, numThreads);
+		s_globalPoolPtr.store(s_pGlobalPool.get(), memory_order_release);
+	}
+	return *s_pGlobalPool;
+}
+
+void MultiCore::configureGlobalPool(size_t numThreads)
+{
+	lock_guard lg(s_globalPoolMutex);
+	s_globalPoolPtr.store(nullptr, memory_order_release);
+	s_pGlobalPool = nullptr;
+
+	numThreads = max(numThreads, (size_t)1);
+	s_pGlobalPool = make_unique<ThreadPool>(numThreads, numThreads, numThreads);
+	s_globalPoolPtr.store(s_pGlobalPool.get(), memory_order_release);
+}
+
+void MultiCore::shutdown()
+{
+	lock_guard lg(s_globalPoolMutex);
+	s_globalPoolPtr.store(nullptr, memory_order_release);
+	s_pGlobalPool = nullptr;
+}
+
+// Polls before parking in atomic::wait. The budget doubles when a poll sees the change and halves when the thread has
+// to park, so threads that are re-dispatched quickly stay awake and idle ones go to sleep. No spinning on one core.
+#define POOL_SPIN_MIN 16
+#define POOL_SPIN_MAX (16 * 1024)
+
+namespace
+{
+
+inline void cpuRelax()
+{
+#if defined(_M_X64) || defined(__x86_64__) || defined(__i386__)
+	_mm_pause();
+#else
+	this_thread::yield();
+#endif
+}
+
+// Returns once val != old
+void waitWhileEqual(const atomic<uint32_t>& val, uint32_t old, uint32_t& spinBudget)
+{
+	if (getNumCores() > 1) {
+		for (uint32_t i = 0; i < spinBudget; i++) {
+			if (val.load(memory_order_acquire) != old) {
+				spinBudget = min(spinBudget * 2, (uint32_t)POOL_SPIN_MAX);
+				return;
+			}
+			cpuRelax();
+		}
+		spinBudget = max(spinBudget / 2, (uint32_t)POOL_SPIN_MIN);
+	}
+
+	while (val.load(memory_order_acquire) == old)
+		val.wait(old, memory_order_acquire);
+}
+
+thread_local uint32_t s_callerSpinBudget = POOL_SPIN_MAX;
+
+}
+
+struct ThreadPool::Job {
+	const FuncType* _pFunc = nullptr;
+	RangeScheduler* _pScheduler = nullptr;
+	uint64_t _rootId = 0; // Id of the outermost run this one is nested in, or its own
+	atomic<size_t> _numHelpers = 0;
+	atomic<bool> _failed = false;
+	exception_ptr _exception; // First exception thrown by _pFunc, written once by whoever set _failed
+
+	// Instrumentation, _pBusyNs has a counter per scheduler participant when stats are on
+	int _statsMode = STATS_OFF;
+	uint64_t _runId = 0;
+	size_t _numSteps = 0;
+	unique_ptr<atomic<uint64_t>[]> _pBusyNs;
+	size_t _numBusyCounters = 0;
+};
+
+// Counters are atomics so getStats can read them while threads run. Slot 0 is shared by every caller.
+struct ThreadPool::StatsSlot {
+	StatsSlot(size_t worker);
+
+	void reset();
+
+	const size_t _worker;
+	atomic<uint64_t> _busyNs = 0;
+	atomic<uint64_t> _waitNs = 0;
+	atomic<uint64_t> _idleNs = 0;
+	atomic<size_t> _numChunks = 0;
+	atomic<size_t> _numTasks = 0;
+
+	mutex _eventMutex;
+	vector<PoolTraceEvent> _events;
+	size_t _numDroppedEvents = 0;
+};
+
+ThreadPool::StatsSlot::StatsSlot(size_t worker)
+	: _worker(worker)
+{
+}
+
+void ThreadPool::StatsSlot::reset()
+{
+	_busyNs.store(0, memory_order_relaxed);
+	_waitNs.store(0, memory_order_relaxed);
+	_idleNs.store(0, memory_order_relaxed);
+	_numChunks.store(0, memory_order_relaxed);
+	_numTasks.store(0, memory_order_relaxed);
+
+	lock_guard lg(_eventMutex);
+	_events.clear();
+	_numDroppedEvents = 0;
+}
+
+namespace
+{
+
+// The run the calling thread is taking part in, if any. A run started while this is set for the same pool is nested.
+thread_local const ThreadPool* t_pRunPool = nullptr;
+thread_local uint64_t t_runRootId = 0;
+atomic<uint64_t> s_nextRootId = 1;
+
+// Pool and stats slot of a pool thread, any other thread uses slot 0
+thread_local const ThreadPool* t_pWorkerPool = nullptr;
+thread_local size_t t_workerSlot = 0;
+
+// Number of timed chunks and tasks the thread is inside of, only the outermost adds to the thread's busy time.
+// t_busyNs totals what it did add, so a span's wait time is its length less the busy time within it.
+thread_local size_t t_statsDepth = 0;
+thread_local uint64_t t_busyNs = 0;
+
+uint64_t steadyNs()
+{
+	return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+class scoped_run_context {
+public:
+	scoped_run_context(const ThreadPool* pPool, uint64_t rootId)
+		: _pPriorPool(t_pRunPool)
+		, _priorRootId(t_runRootId)
+	{
+		t_pRunPool = pPool;
+		t_runRootId = rootId;
+	}
+
+	~scoped_run_context()
+	{
+		t_pRunPool = _pPriorPool;
+		t_runRootId = _priorRootId;
+	}
+
+private:
+	const ThreadPool* _pPriorPool;
+	uint64_t _priorRootId;
+};
+
+}
+
+// RangeScheduler observer timing a participant's chunks
+struct ThreadPool::ChunkTimer {
+	ChunkTimer(const ThreadPool& pool, Job& job, size_t participant);
+	~ChunkTimer();
+
+	void chunkBegin(size_t begin, size_t end);
+	void chunkEnd();
+
+	const ThreadPool& _pool;
+	Job& _job;
+	StatsSlot& _slot;
+	const size_t _participant;
+	size_t _begin = 0, _end = 0;
+	uint64_t _startNs = 0;
+	bool _inChunk = false;
+};
+
+ThreadPool::ChunkTimer::ChunkTimer(const ThreadPool& pool, Job& job, size_t participant)
+	: _pool(pool)
+	, _job(job)
+	, _slot(pool.getStatsSlot())
+	, _participant(participant)
+{
+}
+
+ThreadPool::ChunkTimer::~ChunkTimer()
+{
+	// f threw, runParticipant never got to end the chunk
+	if (_inChunk)
+		chunkEnd();
+}
+
+inline void ThreadPool::ChunkTimer::chunkBegin(size_t begin, size_t end)
+{
+	_begin = begin;
+	_end = end;
+	_inChunk = true;
+	t_statsDepth++;
+	_startNs = steadyNs();
+}
+
+inline void ThreadPool::ChunkTimer::chunkEnd()
+{
+	uint64_t endNs = steadyNs();
+	uint64_t busyNs = endNs - _startNs;
+	_inChunk = false;
+	t_statsDepth--;
+
+	_job._pBusyNs[_participant].fetch_add(busyNs, memory_order_relaxed);
+	if (t_statsDepth == 0) {
+		_slot._busyNs.fetch_add(busyNs, memory_order_relaxed);
+		_slot._numChunks.fetch_add(1, memory_order_relaxed);
+		t_busyNs += busyNs;
+	}
+
+	if (_job._statsMode == STATS_TRACE)
+		_pool.recordEvent(_slot, PoolTraceEvent::CHUNK, _startNs, endNs, _job._runId, _begin, _end);
+}
+
 class ThreadPool::Thread {
 public:
 	template<class FUNC>
-	inline Thread(FUNC f, ThreadPool* pPool)
-		: _thread(f, pPool, this)
+	inline Thread(FUNC f, ThreadPool* pPool, int cpu, size_t statsSlot)
+		: _cpu(cpu)
+		, _statsSlot(statsSlot)
+		, _thread(f, pPool, this)
 	{
 	}
 
@@ -72,24 +319,61 @@ public:
 		_thread.join();
 	}
 
-	std::thread::id _ownerThreadId;
-	Stage _stage = AT_NOT_CREATED;
-	const FuncType* _pThreadFunc = nullptr;
-	mutable size_t _numThreadsForThisFunc = 0;
-	mutable size_t _numSteps = 0;
-	mutable size_t _ourThreadIndex = -1;
+	// The owner bumps _wakeSeq to start the thread, the thread bumps _doneSeq when it finishes. Each has its own
+	// cache line and a single waiter, so a dispatch wakes exactly one thread.
+	alignas(64) atomic<uint32_t> _wakeSeq = 0;
+	alignas(64) atomic<uint32_t> _doneSeq = 0;
+	uint32_t _expectedDoneSeq = 0;
+	uint32_t _spinBudget = POOL_SPIN_MAX;
+
+	Job* _pJob = nullptr; // nullptr when woken for queued tasks
+	size_t _ourThreadIndex = -1;
+	const int _cpu; // Pin to this cpu on start up, -1 for no pinning
+	const size_t _statsSlot;
 private:
 	_STD thread _thread;
 };
 
-
-
 ThreadPool::ThreadPool(size_t numThreads, size_t numSubThreads, size_t numAllocatedThreads)
 	: _numThreads(numThreads)
 	, _numSubThreads(numSubThreads)
 {
 	// In primary thread
-	start(numAllocatedThreads);
+	start(numAllocatedThreads, false);
+}
+
+namespace
+{
+	size_t orNumCpus(size_t num, size_t numCpus)
+	{
+		return num != 0 ? num : max(numCpus, (size_t)1);
+	}
+}
+
+ThreadPool::ThreadPool(size_t numThreads, size_t numSubThreads, size_t numAllocatedThreads, const PlacementOptions& placement)
+	: ThreadPool(numThreads, numSubThreads, numAllocatedThreads, placement, CpuTopology::get().selectCpus(placement))
+{
+}
+
+ThreadPool::ThreadPool(size_t numThreads, size_t numSubThreads, size_t numAllocatedThreads, const PlacementOptions& placement, const vector<CpuInfo>& cpus)
+	: _numThreads(orNumCpus(numThreads, cpus.size()))
+	, _numSubThreads(orNumCpus(numSubThreads, cpus.size()))
+{
+	// In primary thread. The caller has cpus[0], by default each of the other cpus gets one worker, none if only one
+	// cpu was selected.
+	if (cpus.empty()) {
+		// Unplaced workers could land on reserved cpus, everything runs on the caller instead
+		_noCpusSelected = true;
+		numAllocatedThreads = 0;
+	} else if (numAllocatedThreads == 0) {
+		numAllocatedThreads = cpus.size() - 1;
+	}
+
+	for (size_t i = 0; i < numAllocatedThreads; i++)
+		_workerPlacement.push_back(cpus[(i + 1) % cpus.size()]);
+	_pinned = placement._pinThreads && !_workerPlacement.empty();
+
+	start(numAllocatedThreads, _pinned);
 }
 
 ThreadPool::~ThreadPool()
@@ -98,25 +382,44 @@ ThreadPool::~ThreadPool()
 	stop();
 }
 
-void ThreadPool::start(size_t numAllocatedThreads) {
+void ThreadPool::start(size_t numAllocatedThreads, bool pinThreads) {
 	// In primary thread
 
+	for (size_t i = 0; i <= numAllocatedThreads; i++)
+		_statsSlots.push_back(make_unique<StatsSlot>(i));
+
 	for (size_t i = 0; i < numAllocatedThreads; i++) {
-		_allocatedThreads.push_back(new Thread(runSingleThreadStat, this));
+		int cpu = pinThreads ? _workerPlacement[i]._cpu : -1;
+		_allocatedThreads.push_back(new Thread(runSingleThreadStat, this, cpu, i + 1));
 		_availThreads.push_back(_allocatedThreads.back());
 	}
 }
 
+string ThreadPool::getPlacementReport() const
+{
+	stringstream ss;
+	ss << _allocatedThreads.size() << " workers, " << (_pinned ? "pinned" : "not pinned") << "\n";
+	if (_noCpusSelected)
+		ss << "no cpus left after the placement options, no workers were started, every run is on the calling thread\n";
+	for (size_t i = 0; i < _workerPlacement.size(); i++) {
+		const auto& info = _workerPlacement[i];
+		ss << "worker " << i << ": cpu " << info._cpu << " socket " << info._socket << " core " << info._core
+			<< " smt " << info._smtIndex << " L3 " << info._l3Domain << "\n";
+	}
+	return ss.str();
+}
+
 void ThreadPool::stop()
 {
-	// In primary thread
-	{
-		_running = false;
-		_cv.notify_all();
-		_STD unique_lock lk(_stageMutex);
-		_cv.wait(lk, [this]()->bool {
-			return atStage(_allocatedThreads, AT_TERMINATED);
-		});
+	// In primary thread. Queued tasks have waiters, futures, graph nodes and coroutines, run them before the
+	// workers go. Workers busy with tasks keep at it until the queue is empty.
+	while (runPendingTask()) {
+	}
+
+	_running.store(false, memory_order_release);
+	for (auto& t : _allocatedThreads) {
+		t->_wakeSeq.fetch_add(1, memory_order_release);
+		t->_wakeSeq.notify_one();
 	}
 
 	for (auto& t : _allocatedThreads) {
@@ -125,137 +428,328 @@ void ThreadPool::stop()
 	}
 	_allocatedThreads.clear();
 	_availThreads.clear();
+
+	// Tasks queued by tasks that were still running above, with no workers left enqueue only queues
+	while (runPendingTask()) {
+	}
 }
 
-bool ThreadPool::atStage(const _STD vector<Thread*>& ourThreads, Stage st) const
+void ThreadPool::acquireThreads(size_t numRequested, size_t numSteps, size_t minStepsToMultiThread, _STD vector<Thread*>& ourThreads) const
 {
-	for (auto pThread : ourThreads) {
-		if (pThread->_ownerThreadId == this_thread::get_id() && pThread->_stage != st)
-			return false;
+	ourThreads.clear();
+
+	lock_guard lg(_stackMutex);
+	size_t num = 0;
+	if (minStepsToMultiThread != (size_t)-1) {
+		size_t numStepsPerThread = std::max((size_t)1, minStepsToMultiThread / 3);
+		size_t numRecommended = std::max((size_t)1, numSteps / numStepsPerThread);
+		num = std::min(numRequested, numRecommended);
+		num = std::min(num, _availThreads.size() + 1);
+	} else {
+		num = std::min(numRequested, _availThreads.size() + 1);
+	}
+	if (num < 1)
+		num = 1;
+	for (size_t i = 0; i < num - 1; i++) {
+		ourThreads.push_back(_availThreads.back());
+		_availThreads.pop_back();
 	}
-	_cv.notify_all();
-	return true;
 }
 
-bool ThreadPool::atStage(const _STD vector<Thread*>& ourThreads, Stage st0, Stage st1) const
+bool ThreadPool::acquireAllThreads(size_t numRequested, _STD vector<Thread*>& ourThreads) const
 {
-	for (auto pThread : ourThreads) {
-		if (pThread->_ownerThreadId == this_thread::get_id() && pThread->_stage != st0 && pThread->_stage != st1)
-			return false;
+	// The caller is one of the threads
+	ourThreads.clear();
+
+	lock_guard lg(_stackMutex);
+	if (numRequested > _availThreads.size() + 1)
+		return false;
+	for (size_t i = 0; i + 1 < numRequested; i++) {
+		ourThreads.push_back(_availThreads.back());
+		_availThreads.pop_back();
 	}
-	_cv.notify_all();
 	return true;
 }
 
-void ThreadPool::setStageForAll(const _STD vector<Thread*>& ourThreads, Stage st) const
+void ThreadPool::runConcurrent_private(size_t numThreads, const FuncType& func) const
 {
-	for (auto pThread : ourThreads) {
-		assert(pThread->_ownerThreadId == this_thread::get_id());
-		pThread->_stage = st;
+	numThreads = max(numThreads, (size_t)1);
+
+	// One step per participant, strided gives participant i step i
+	vector<Thread*> ourThreads;
+	if (acquireAllThreads(numThreads, ourThreads)) {
+		runFunc_acquired(numThreads, numThreads, func, Partitioner::strided(), ourThreads, nullptr);
+		return;
+	}
+
+	// Too few idle workers, a worker running two of the calls in turn would deadlock if they wait for each other
+	mutex exceptionMutex;
+	exception_ptr pException;
+	auto runOne = [&func, &exceptionMutex, &pException](size_t threadNum) {
+		try {
+			func(threadNum, threadNum);
+		} catch (...) {
+			lock_guard lg(exceptionMutex);
+			if (!pException)
+				pException = current_exception();
+		}
+	};
+
+	vector<thread> threads;
+	threads.reserve(numThreads - 1);
+	for (size_t i = 1; i < numThreads; i++)
+		threads.push_back(thread(runOne, i));
+	runOne(0);
+
+	for (auto& t : threads)
+		t.join();
+
+	if (pException)
+		rethrow_exception(pException);
+}
+
+void ThreadPool::releaseThreads(const _STD vector<Thread*>& ourThreads) const
+{
+	// The owner returns its threads once they have all finished. Releasing from the worker would let another caller
+	// re-dispatch a thread before its owner has seen the done signal.
+	{
+		lock_guard lg(_stackMutex);
+		for (auto pThread : ourThreads)
+			_availThreads.push_back(pThread);
 	}
-	_cv.notify_all();
+
+	if (_numTasks.load(memory_order_acquire) > 0)
+		wakeThreadForTasks();
 }
 
-void ThreadPool::setStageFromWorkerThread(Stage st, Thread* pThread) const
+void ThreadPool::dispatch(Thread* pThread) const
 {
-	pThread->_stage = st;
-	_cv.notify_all();
+	pThread->_wakeSeq.fetch_add(1, memory_order_release);
+	pThread->_wakeSeq.notify_one();
 }
 
-void ThreadPool::acquireThreads(size_t numRequested, size_t numSteps, size_t minStepsToMultiThread, const FuncType& func, _STD vector<Thread*>& ourThreads) const
+void ThreadPool::enqueue(TaskType task) const
 {
-	ourThreads.clear();
+	{
+		lock_guard lg(_taskMutex);
+		_tasks.push_back(_STD move(task));
+		_numTasks.fetch_add(1, memory_order_release);
+	}
 
-	size_t num = 0;
+	wakeThreadForTasks();
+}
+
+bool ThreadPool::runPendingTask() const
+{
+	if (_numTasks.load(memory_order_acquire) == 0)
+		return false;
+
+	TaskType task;
 	{
-		lock_guard lg(_stackMutex);
-		if (minStepsToMultiThread != -1) {
-			size_t numStepsPerThread = minStepsToMultiThread / 3;
-			size_t numRecommended = std::max((size_t)1, numSteps / numStepsPerThread);
-			num = std::min(numRequested, numRecommended);
-			num = std::min(num, _availThreads.size());
-		} else {
-			num = std::min(numRequested, _availThreads.size());
-		}
-		if (num < 1)
-			num = 1;
-		for (size_t i = 0; i < num - 1; i++) {
-			auto pThread = _availThreads.back();
-			pThread->_ownerThreadId = this_thread::get_id();
-			_availThreads.pop_back();
-			ourThreads.push_back(pThread);
-		}
+		lock_guard lg(_taskMutex);
+		if (_tasks.empty())
+			return false;
+		task = _STD move(_tasks.front());
+		_tasks.pop_front();
+		_numTasks.fetch_sub(1, memory_order_release);
 	}
 
-	for (size_t i = 0; i < ourThreads.size(); i++) {
-		auto pThread = ourThreads[i];
+	if (_statsMode.load(memory_order_relaxed) == STATS_OFF) {
+		task();
+		return true;
+	}
 
-		pThread->_pThreadFunc = &func;
-		pThread->_numThreadsForThisFunc = ourThreads.size() + 1;
-		pThread->_numSteps = numSteps;
-		pThread->_ourThreadIndex = i;
+	auto& slot = getStatsSlot();
+	uint64_t startNs = steadyNs();
+	size_t depth = t_statsDepth++;
+	try {
+		task();
+	} catch (...) {
+		t_statsDepth = depth;
+		throw;
+	}
+	t_statsDepth = depth;
+	uint64_t endNs = steadyNs();
+
+	slot._numTasks.fetch_add(1, memory_order_relaxed);
+	if (depth == 0) {
+		slot._busyNs.fetch_add(endNs - startNs, memory_order_relaxed);
+		t_busyNs += endNs - startNs;
 	}
+	if (_statsMode.load(memory_order_relaxed) == STATS_TRACE)
+		recordEvent(slot, PoolTraceEvent::TASK, startNs, endNs);
 
+	return true;
 }
 
-void ThreadPool::releaseThread(Thread* pThread) const
+void ThreadPool::wakeThreadForTasks() const
 {
-	pThread->_ownerThreadId = {};
-	pThread->_pThreadFunc = nullptr;
-	pThread->_numThreadsForThisFunc = 0;
-	pThread->_numSteps = 0;
-	pThread->_ourThreadIndex = -1;
-
+	// A thread dispatched without a function drains the task queue and then returns itself to the available list
+	Thread* pThread = nullptr;
 	{
 		lock_guard lg(_stackMutex);
-		_availThreads.push_back(pThread);
+		if (_availThreads.empty())
+			return;
+		pThread = _availThreads.back();
+		_availThreads.pop_back();
 	}
 
-	_cv.notify_all();
+	pThread->_pJob = nullptr;
+	dispatch(pThread);
 }
 
-void ThreadPool::runFunc_private(size_t numThreads, size_t numSteps, size_t minStepsToMultiThread, const FuncType& func, _STD vector<Thread*>& ourThreads) const
+bool ThreadPool::runFunc_private(size_t numThreads, size_t numSteps, size_t minStepsToMultiThread, const FuncType& func, const Partitioner& part, _STD vector<Thread*>& ourThreads, const CancellationToken* pCancel) const
 {
 	// In owner thread
-	{
-		_STD unique_lock lk(_stageMutex);
-		_cv.wait(lk, [this, numThreads, numSteps, minStepsToMultiThread, &func, &ourThreads]()->bool {
-			acquireThreads(numThreads, numSteps, minStepsToMultiThread, func, ourThreads);
-			return true;
-		});
+	acquireThreads(numThreads, numSteps, minStepsToMultiThread, ourThreads);
+	return runFunc_acquired(numThreads, numSteps, func, part, ourThreads, pCancel);
+}
+
+bool ThreadPool::runFunc_acquired(size_t numThreads, size_t numSteps, const FuncType& func, const Partitioner& part, _STD vector<Thread*>& ourThreads, const CancellationToken* pCancel) const
+{
+	// In owner thread, ourThreads have been taken from the available list
+	const bool nested = t_pRunPool == this;
+
+	// A nested run leaves its unfilled slots open for threads of the same outer run
+	RangeScheduler scheduler(numSteps, ourThreads.size() + 1, part, nested ? numThreads : 0, pCancel);
+	Job job;
+	job._pFunc = &func;
+	job._pScheduler = &scheduler;
+	job._rootId = nested ? t_runRootId : s_nextRootId.fetch_add(1, memory_order_relaxed);
+
+	uint64_t startNs = 0, busyNsBefore = 0;
+	job._statsMode = _statsMode.load(memory_order_relaxed);
+	if (job._statsMode != STATS_OFF) {
+		startNs = steadyNs();
+		busyNsBefore = t_busyNs;
+		job._runId = _nextRunId.fetch_add(1, memory_order_relaxed);
+		job._numSteps = numSteps;
+
+		job._numBusyCounters = max(ourThreads.size() + 1, nested ? numThreads : 0);
+		job._pBusyNs = make_unique<atomic<uint64_t>[]>(job._numBusyCounters);
+		for (size_t i = 0; i < job._numBusyCounters; i++)
+			job._pBusyNs[i].store(0, memory_order_relaxed);
 	}
 
-	{
-		_STD unique_lock lk(_stageMutex);
-		_cv.wait(lk, [this, &ourThreads]()->bool {
-			return atStage(ourThreads, AT_STOPPED);
-		});
+	const bool open = nested && scheduler.acceptsHelpers();
+	if (open) {
+		lock_guard lg(_jobMutex);
+		_openJobs.push_back(&job);
+		_numOpenJobs.fetch_add(1, memory_order_release);
+	}
 
-		setStageForAll(ourThreads, AT_RUNNING);
+	for (size_t i = 0; i < ourThreads.size(); i++) {
+		auto pThread = ourThreads[i];
+		pThread->_pJob = &job;
+		pThread->_ourThreadIndex = i;
+		pThread->_expectedDoneSeq = pThread->_doneSeq.load(memory_order_relaxed) + 1;
+		dispatch(pThread);
 	}
 
-	size_t startIndex = 0;
-	size_t stride = ourThreads.size() + 1;
-	for (size_t i = startIndex; i < numSteps; i += stride) {
-		if (!func(startIndex, i))
-			break;
+	runJob(job, 0);
+	uint64_t waitStartNs = job._statsMode != STATS_OFF ? steadyNs() : 0;
+
+	if (open) {
+		lock_guard lg(_jobMutex);
+		_openJobs.erase(find(_openJobs.begin(), _openJobs.end(), &job));
+		_numOpenJobs.fetch_sub(1, memory_order_release);
 	}
 
-	{
-		_STD unique_lock lk(_stageMutex);
-		_cv.wait(lk, [this, &ourThreads]()->bool {
-			return atStage(ourThreads, AT_STOPPED);
-		});
+	for (auto pThread : ourThreads) {
+		uint32_t doneSeq;
+		while ((doneSeq = pThread->_doneSeq.load(memory_order_acquire)) != pThread->_expectedDoneSeq) {
+			// Our workers may be in nested runs of their own, help rather than sleep
+			if (helpOpenJob(job._rootId))
+				continue;
+			// Only nested runs of ours can free a slot soon, jobs of other runs are no reason to stay awake
+			if (hasOpenJob(job._rootId)) {
+				this_thread::yield();
+				continue;
+			}
+			waitWhileEqual(pThread->_doneSeq, doneSeq, s_callerSpinBudget);
+		}
+	}
 
-		_cv.notify_all();
+	// Helpers leave as soon as the job runs out of work, and they touch the job until they do
+	while (job._numHelpers.load(memory_order_acquire) != 0)
+		this_thread::yield();
+
+	if (job._statsMode != STATS_OFF)
+		recordRun(job, numSteps, ourThreads.size() + 1, startNs, waitStartNs, busyNsBefore);
+
+	releaseThreads(ourThreads);
+
+	// Everyone is out of the job, rethrow on the caller's thread
+	if (job._exception)
+		rethrow_exception(job._exception);
+
+	return !scheduler.isCancelled();
+}
+
+void ThreadPool::runJob(Job& job, size_t participant) const
+{
+	scoped_run_context context(this, job._rootId);
+
+	const FuncType& func = *job._pFunc;
+	auto f = [&func, participant](size_t i)->bool {
+		return func(participant, i);
+	};
+
+	try {
+		if (job._statsMode == STATS_OFF) {
+			job._pScheduler->runParticipant(participant, f);
+		} else {
+			ChunkTimer timer(*this, job, participant);
+			job._pScheduler->runParticipant(participant, f, timer);
+		}
+	} catch (...) {
+		// An exception must not leave a worker's thread function, keep the first one for the caller and stop the rest
+		if (!job._failed.exchange(true, memory_order_acq_rel))
+			job._exception = current_exception();
+		job._pScheduler->cancel();
 	}
+}
 
-	{
-		_STD unique_lock lk(_stageMutex);
-		_cv.wait(lk, [this]()->bool {
+bool ThreadPool::hasOpenJob(uint64_t rootId) const
+{
+	if (_numOpenJobs.load(memory_order_acquire) == 0)
+		return false;
+
+	lock_guard lg(_jobMutex);
+	for (auto pOpen : _openJobs) {
+		if (pOpen->_rootId == rootId)
 			return true;
-		});
 	}
+	return false;
+}
+
+bool ThreadPool::helpOpenJob(uint64_t rootId) const
+{
+	if (_numOpenJobs.load(memory_order_acquire) == 0)
+		return false;
+
+	Job* pJob = nullptr;
+	size_t participant = -1;
+	{
+		lock_guard lg(_jobMutex);
+		for (auto pOpen : _openJobs) {
+			if (pOpen->_rootId != rootId)
+				continue;
+			participant = pOpen->_pScheduler->claimHelper();
+			if (participant != (size_t)-1) {
+				pJob = pOpen;
+				pJob->_numHelpers.fetch_add(1, memory_order_relaxed);
+				break;
+			}
+		}
+	}
+
+	if (!pJob)
+		return false;
+
+	runJob(*pJob, participant);
+	pJob->_numHelpers.fetch_sub(1, memory_order_release);
+	return true;
 }
 
 void ThreadPool::runSingleThreadStat(ThreadPool* pSelf, Thread* pThread) {
@@ -263,38 +757,188 @@ void ThreadPool::runSingleThreadStat(ThreadPool* pSelf, Thread* pThread) {
 }
 
 void ThreadPool::runSingleThread(Thread* pThread) {
-	{
-		_STD unique_lock lk(_stageMutex);
-		setStageFromWorkerThread(AT_STOPPED, pThread);
-	}
 	// In worker thread
-	while (_running) {
-		{
-			_STD unique_lock lk(_stageMutex);
-			_cv.wait(lk, [this, pThread]()->bool {
-				return (pThread->_stage == AT_RUNNING) || !_running;
-			});
+	if (pThread->_cpu >= 0)
+		CpuTopology::pinCurrentThread(pThread->_cpu);
+
+	t_pWorkerPool = this;
+	t_workerSlot = pThread->_statsSlot;
+
+	uint32_t wakeSeq = 0;
+	while (true) {
+		uint64_t idleStartNs = _statsMode.load(memory_order_relaxed) != STATS_OFF ? steadyNs() : 0;
+
+		uint32_t seq;
+		while ((seq = pThread->_wakeSeq.load(memory_order_acquire)) == wakeSeq)
+			waitWhileEqual(pThread->_wakeSeq, wakeSeq, pThread->_spinBudget);
+		wakeSeq = seq;
+
+		if (!_running.load(memory_order_acquire))
+			break;
+
+		if (idleStartNs != 0 && _statsMode.load(memory_order_relaxed) != STATS_OFF) {
+			auto& slot = getStatsSlot();
+			uint64_t endNs = steadyNs();
+			slot._idleNs.fetch_add(endNs - idleStartNs, memory_order_relaxed);
+			if (_statsMode.load(memory_order_relaxed) == STATS_TRACE)
+				recordEvent(slot, PoolTraceEvent::IDLE, idleStartNs, endNs);
 		}
 
-		auto pFunc = pThread->_pThreadFunc;
-		if (pFunc) {
-			size_t startIndex = pThread->_ourThreadIndex + 1;
-			size_t numSteps = pThread->_numSteps;
-			size_t stride = pThread->_numThreadsForThisFunc;
-			for (size_t i = startIndex; i < numSteps; i += stride) {
-				if (!(*pFunc)(startIndex, i))
-					break;
+		auto pJob = pThread->_pJob;
+		if (pJob) {
+			uint64_t startNs = pJob->_statsMode != STATS_OFF ? steadyNs() : 0;
+			uint64_t busyNsBefore = t_busyNs;
+
+			runJob(*pJob, pThread->_ourThreadIndex + 1);
+
+			// Out of work. Nested runs of the same outer run hold up our owner as much as we would, join them.
+			uint64_t rootId = pJob->_rootId;
+			while (helpOpenJob(rootId)) {
+			}
+
+			// Our part of the run, less the chunks and tasks run in it
+			if (startNs != 0) {
+				auto& slot = getStatsSlot();
+				uint64_t endNs = steadyNs();
+				slot._waitNs.fetch_add((endNs - startNs) - (t_busyNs - busyNsBefore), memory_order_relaxed);
+				if (pJob->_statsMode == STATS_TRACE)
+					recordEvent(slot, PoolTraceEvent::RUN, startNs, endNs, pJob->_runId, 0, pJob->_numSteps);
 			}
-		}
 
-		{
-			_STD unique_lock lk(_stageMutex);
-			// This the reason shared threads exist.
-			// When this function completes, put this thread back in the pool so it can be reassigned.
-			releaseThread(pThread);
-			setStageFromWorkerThread(AT_STOPPED, pThread);
+			pThread->_pJob = nullptr;
+			pThread->_ourThreadIndex = -1;
+
+			pThread->_doneSeq.fetch_add(1, memory_order_release);
+			pThread->_doneSeq.notify_one();
+		} else {
+			// No owner, woken for queued tasks
+			while (runPendingTask()) {
+			}
+
+			{
+				lock_guard lg(_stackMutex);
+				_availThreads.push_back(pThread);
+			}
+
+			// A task queued after the queue was seen empty, and before we were available, would have found no thread
+			if (_numTasks.load(memory_order_acquire) > 0)
+				wakeThreadForTasks();
 		}
 	}
-	_STD unique_lock lk(_stageMutex);
-	setStageFromWorkerThread(AT_TERMINATED, pThread);
+}
+
+ThreadPool::StatsSlot& ThreadPool::getStatsSlot() const
+{
+	return *_statsSlots[t_pWorkerPool == this ? t_workerSlot : 0];
+}
+
+void ThreadPool::recordEvent(StatsSlot& slot, PoolTraceEvent::Kind kind, uint64_t startNs, uint64_t endNs, uint64_t runId, size_t begin, size_t end) const
+{
+	// Times are kept absolute until here, anything that started before a reset is clipped to it
+	uint64_t epochNs = _statsEpochNs.load(memory_order_relaxed);
+	if (endNs < epochNs)
+		return;
+	startNs = max(startNs, epochNs);
+
+	PoolTraceEvent ev;
+	ev._kind = kind;
+	ev._worker = slot._worker;
+	ev._startNs = startNs - epochNs;
+	ev._durationNs = endNs - startNs;
+	ev._runId = runId;
+	ev._begin = begin;
+	ev._end = end;
+
+	lock_guard lg(slot._eventMutex);
+	if (slot._events.size() < POOL_TRACE_MAX_EVENTS)
+		slot._events.push_back(ev);
+	else
+		slot._numDroppedEvents++;
+}
+
+void ThreadPool::recordRun(const Job& job, size_t numSteps, size_t numParticipants, uint64_t startNs, uint64_t waitStartNs, uint64_t busyNsBefore) const
+{
+	auto& slot = getStatsSlot();
+	uint64_t endNs = steadyNs();
+
+	// A run nested in a chunk is already part of that chunk's busy time
+	if (t_statsDepth == 0)
+		slot._waitNs.fetch_add((endNs - startNs) - (t_busyNs - busyNsBefore), memory_order_relaxed);
+
+	if (job._statsMode == STATS_TRACE) {
+		recordEvent(slot, PoolTraceEvent::RUN, startNs, endNs, job._runId, 0, numSteps);
+		recordEvent(slot, PoolTraceEvent::WAIT, waitStartNs, endNs, job._runId);
+	}
+
+	PoolRunStats run;
+	run._runId = job._runId;
+	run._startNs = startNs - min(startNs, _statsEpochNs.load(memory_order_relaxed));
+	run._wallNs = endNs - startNs;
+	run._numSteps = numSteps;
+
+	// Every participant the run started with counts, an idle one is imbalance. Helpers count if they did something.
+	for (size_t i = 0; i < job._numBusyCounters; i++) {
+		uint64_t busyNs = job._pBusyNs[i].load(memory_order_relaxed);
+		if (i >= numParticipants && busyNs == 0)
+			continue;
+		run._numParticipants++;
+		run._busyNs += busyNs;
+		run._maxBusyNs = max(run._maxBusyNs, busyNs);
+	}
+
+	lock_guard lg(_statsMutex);
+	_runStats.push_back(run);
+	if (_runStats.size() > POOL_STATS_MAX_RUNS)
+		_runStats.pop_front();
+}
+
+void ThreadPool::enableStats(bool enable, bool trace) const
+{
+	if (enable && _statsMode.load(memory_order_relaxed) == STATS_OFF)
+		resetStats();
+	_statsMode.store(enable ? (trace ? STATS_TRACE : STATS_ON) : STATS_OFF, memory_order_relaxed);
+}
+
+bool ThreadPool::isStatsEnabled() const
+{
+	return _statsMode.load(memory_order_relaxed) != STATS_OFF;
+}
+
+PoolStats ThreadPool::getStats() const
+{
+	PoolStats stats;
+	stats._workers.resize(_statsSlots.size());
+	for (size_t i = 0; i < _statsSlots.size(); i++) {
+		const auto& slot = *_statsSlots[i];
+		auto& worker = stats._workers[i];
+		worker._busyNs = slot._busyNs.load(memory_order_relaxed);
+		worker._waitNs = slot._waitNs.load(memory_order_relaxed);
+		worker._idleNs = slot._idleNs.load(memory_order_relaxed);
+		worker._numChunks = slot._numChunks.load(memory_order_relaxed);
+		worker._numTasks = slot._numTasks.load(memory_order_relaxed);
+
+		lock_guard lg(_statsSlots[i]->_eventMutex);
+		stats._events.insert(stats._events.end(), slot._events.begin(), slot._events.end());
+		stats._numDroppedEvents += slot._numDroppedEvents;
+	}
+
+	// Each slot appends events as they end, enclosing ones come after what they contain
+	stable_sort(stats._events.begin(), stats._events.end(), [](const PoolTraceEvent& lhs, const PoolTraceEvent& rhs) {
+		return lhs._worker != rhs._worker ? lhs._worker < rhs._worker : lhs._startNs < rhs._startNs;
+	});
+
+	lock_guard lg(_statsMutex);
+	stats._runs.assign(_runStats.begin(), _runStats.end());
+
+	return stats;
+}
+
+void ThreadPool::resetStats() const
+{
+	_statsEpochNs.store(steadyNs(), memory_order_relaxed);
+	for (auto& pSlot : _statsSlots)
+		pSlot->reset();
+
+	lock_guard lg(_statsMutex);
+	_runStats.clear();
 }
@@ -0,0 +1,125 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Copyright Robert R Tipton, 2022, all rights reserved except those granted in prior license statement.
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <fstream>
+#include <PoolStats.h>
+
+using namespace std;
+using namespace MultiCore;
+
+double PoolRunStats::getImbalance() const
+{
+	if (_busyNs == 0 || _numParticipants == 0)
+		return 1;
+	return _maxBusyNs * (double)_numParticipants / _busyNs;
+}
+
+double PoolStats::getMeanImbalance() const
+{
+	if (_runs.empty())
+		return 1;
+
+	double sum = 0;
+	for (const auto& run : _runs)
+		sum += run.getImbalance();
+	return sum / _runs.size();
+}
+
+namespace
+{
+
+const char* getEventName(PoolTraceEvent::Kind kind)
+{
+	switch (kind) {
+		case PoolTraceEvent::RUN:
+			return "run";
+		case PoolTraceEvent::CHUNK:
+			return "chunk";
+		case PoolTraceEvent::TASK:
+			return "task";
+		case PoolTraceEvent::WAIT:
+			return "wait";
+		default:
+		case PoolTraceEvent::IDLE:
+			return "idle";
+	}
+}
+
+}
+
+void PoolStats::writeChromeTrace(ostream& out) const
+{
+	// Complete ("X") events, timestamps in microseconds. One track per worker, track 0 is the callers.
+	out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+	const char* pSep = "";
+	for (size_t i = 0; i < _workers.size(); i++) {
+		out << pSep << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i << ",\"args\":{\"name\":\"";
+		if (i == 0)
+			out << "callers";
+		else
+			out << "worker " << (i - 1);
+		out << "\"}}";
+		pSep = ",\n";
+	}
+
+	auto oldPrecision = out.precision(3);
+	auto oldFlags = out.setf(ios::fixed, ios::floatfield);
+	for (size_t i = 0; i < _events.size(); i++) {
+		const auto& ev = _events[i];
+		out << pSep << "{\"name\":\"" << getEventName(ev._kind) << "\",\"cat\":\"pool\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ev._worker
+			<< ",\"ts\":" << ev._startNs / 1000.0 << ",\"dur\":" << ev._durationNs / 1000.0;
+		switch (ev._kind) {
+			case PoolTraceEvent::RUN:
+				out << ",\"args\":{\"run\":" << ev._runId << ",\"steps\":" << ev._end << "}";
+				break;
+			case PoolTraceEvent::CHUNK:
+				out << ",\"args\":{\"run\":" << ev._runId << ",\"begin\":" << ev._begin << ",\"end\":" << ev._end << "}";
+				break;
+			case PoolTraceEvent::WAIT:
+				out << ",\"args\":{\"run\":" << ev._runId << "}";
+				break;
+			default:
+				break;
+		}
+		out << "}";
+		pSep = ",\n";
+	}
+	out.flags(oldFlags);
+	out.precision(oldPrecision);
+
+	out << "\n]}\n";
+}
+
+bool PoolStats::writeChromeTrace(const string& filename) const
+{
+	ofstream out(filename);
+	if (!out.good())
+		return false;
+	writeChromeTrace(out);
+	return out.good();
+}
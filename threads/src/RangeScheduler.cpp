@@ -0,0 +1,317 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Copyright Robert R Tipton, 2022, all rights reserved except those granted in prior license statement.
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <assert.h>
+#include <algorithm>
+#include <thread>
+#include <RangeScheduler.h>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// A stealer that finds nothing pauses before its next sweep, doubling from 1 to RANGE_STEAL_BACKOFF_MAX pauses and
+// yielding the cpu once at the cap, so idle participants don't hammer the victims' deques.
+#define RANGE_STEAL_BACKOFF_MAX 1024
+
+using namespace std;
+using namespace MultiCore;
+
+namespace
+{
+
+inline void cpuRelax()
+{
+#if defined(_M_X64) || defined(__x86_64__) || defined(__i386__)
+	_mm_pause();
+#else
+	this_thread::yield();
+#endif
+}
+
+}
+
+void RangeDeque::push(size_t begin, size_t end)
+{
+	// Owner only
+	int64_t b = _bottom.load(memory_order_relaxed);
+	assert(b - _top.load(memory_order_acquire) < RANGE_DEQUE_SIZE);
+
+	Slot& slot = _slots[b & (RANGE_DEQUE_SIZE - 1)];
+	slot._begin.store(begin, memory_order_relaxed);
+	slot._end.store(end, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	_bottom.store(b + 1, memory_order_relaxed);
+}
+
+bool RangeDeque::pop(size_t& begin, size_t& end)
+{
+	// Owner only
+	int64_t b = _bottom.load(memory_order_relaxed) - 1;
+	_bottom.store(b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	int64_t t = _top.load(memory_order_relaxed);
+
+	if (t > b) {
+		_bottom.store(b + 1, memory_order_relaxed);
+		return false;
+	}
+
+	const Slot& slot = _slots[b & (RANGE_DEQUE_SIZE - 1)];
+	begin = slot._begin.load(memory_order_relaxed);
+	end = slot._end.load(memory_order_relaxed);
+	if (t == b) {
+		// Last entry, race the thieves for it
+		bool won = _top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+		_bottom.store(b + 1, memory_order_relaxed);
+		return won;
+	}
+
+	return true;
+}
+
+bool RangeDeque::steal(size_t& begin, size_t& end)
+{
+	int64_t t = _top.load(memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	int64_t b = _bottom.load(memory_order_acquire);
+
+	if (t >= b)
+		return false;
+
+	const Slot& slot = _slots[t & (RANGE_DEQUE_SIZE - 1)];
+	begin = slot._begin.load(memory_order_relaxed);
+	end = slot._end.load(memory_order_relaxed);
+	return _top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+}
+
+RangeScheduler::RangeScheduler(size_t numSteps, size_t numParticipants, const Partitioner& part, size_t maxParticipants, const CancellationToken* pCancel)
+	: _numSteps(numSteps)
+	, _numParticipants(numParticipants > 0 ? numParticipants : 1)
+	, _maxParticipants(max(_numParticipants, maxParticipants))
+	, _part(part)
+	, _numJoined(_numParticipants)
+	, _grainSize(part.getGrainSize())
+	, _numRemaining(numSteps)
+	, _participants(_maxParticipants)
+	, _pCancel(pCancel)
+{
+	if (_grainSize == 0) {
+		switch (_part.getKind()) {
+			case Partitioner::STATIC:
+				_grainSize = (_numSteps + _numParticipants - 1) / _numParticipants;
+				break;
+			case Partitioner::STEALING:
+				_grainSize = _numSteps / (8 * _numParticipants);
+				break;
+			default:
+				break;
+		}
+	}
+	if (_grainSize == 0)
+		_grainSize = 1;
+
+	for (size_t i = 0; i < _numParticipants; i++) {
+		auto& p = _participants[i];
+		p._begin = (_numSteps * i) / _numParticipants;
+		p._end = (_numSteps * (i + 1)) / _numParticipants;
+		p._rand = 0x9e3779b97f4a7c15ull * (i + 1);
+	}
+	for (size_t i = _numParticipants; i < _maxParticipants; i++)
+		_participants[i]._rand = 0x9e3779b97f4a7c15ull * (i + 1);
+}
+
+size_t RangeScheduler::claimHelper()
+{
+	if (!acceptsHelpers() || _numJoined.load(memory_order_relaxed) >= _maxParticipants)
+		return -1;
+
+	// Late joiners have an empty initial slice, they only take shared or stolen work
+	size_t participant = _numJoined.fetch_add(1, memory_order_relaxed);
+	return participant < _maxParticipants ? participant : -1;
+}
+
+void RangeScheduler::retire(Participant& p)
+{
+	if (p._held) {
+		_numRemaining.fetch_sub(p._held, memory_order_acq_rel);
+		p._held = 0;
+	}
+}
+
+bool RangeScheduler::next(size_t participant, size_t& begin, size_t& end, size_t& stride)
+{
+	assert(participant < _maxParticipants);
+	auto& p = _participants[participant];
+
+	if (isCancelled()) {
+		retire(p);
+		return false;
+	}
+
+	stride = 1;
+	switch (_part.getKind()) {
+		default:
+		case Partitioner::STRIDED:
+			if (p._started)
+				return false;
+			p._started = true;
+			begin = participant;
+			end = _numSteps;
+			stride = _numParticipants;
+			return begin < end;
+
+		case Partitioner::STATIC:
+			return nextStatic(participant, begin, end);
+
+		case Partitioner::DYNAMIC:
+			return nextDynamic(begin, end);
+
+		case Partitioner::GUIDED:
+			return nextGuided(begin, end);
+
+		case Partitioner::STEALING:
+			retire(p);
+			if (!nextStealing(participant, begin, end))
+				return false;
+			p._held = end - begin;
+			return true;
+	}
+}
+
+void RangeScheduler::cancel()
+{
+	_cancelled.store(true, memory_order_release);
+}
+
+void RangeScheduler::stop(size_t participant)
+{
+	retire(_participants[participant]);
+}
+
+bool RangeScheduler::nextStatic(size_t participant, size_t& begin, size_t& end)
+{
+	auto& p = _participants[participant];
+
+	size_t chunk = p._numChunks * _numParticipants + participant;
+	if (chunk >= (_numSteps + _grainSize - 1) / _grainSize)
+		return false;
+
+	p._numChunks++;
+	begin = chunk * _grainSize;
+	end = min(begin + _grainSize, _numSteps);
+	return true;
+}
+
+bool RangeScheduler::nextDynamic(size_t& begin, size_t& end)
+{
+	// Cheap early out, keeps finished participants from pushing the cursor far past the end
+	if (_cursor.load(memory_order_relaxed) >= _numSteps)
+		return false;
+
+	begin = _cursor.fetch_add(_grainSize, memory_order_relaxed);
+	if (begin >= _numSteps)
+		return false;
+
+	end = min(begin + _grainSize, _numSteps);
+	return true;
+}
+
+bool RangeScheduler::nextGuided(size_t& begin, size_t& end)
+{
+	begin = _cursor.load(memory_order_relaxed);
+	do {
+		if (begin >= _numSteps)
+			return false;
+
+		size_t chunk = (_numSteps - begin) / (2 * _numParticipants);
+		if (chunk < _grainSize)
+			chunk = _grainSize;
+		end = min(begin + chunk, _numSteps);
+	} while (!_cursor.compare_exchange_weak(begin, end, memory_order_relaxed));
+
+	return true;
+}
+
+bool RangeScheduler::nextStealing(size_t participant, size_t& begin, size_t& end)
+{
+	auto& p = _participants[participant];
+
+	if (!p._started) {
+		p._started = true;
+		begin = p._begin;
+		end = p._end;
+	} else if (!p._deque.pop(begin, end)) {
+		size_t backoff = 1;
+		while (!trySteal(participant, begin, end)) {
+			// Cancelled work is never retired, don't wait for it
+			if (_numRemaining.load(memory_order_acquire) == 0 || isCancelled())
+				return false;
+
+			if (backoff < RANGE_STEAL_BACKOFF_MAX) {
+				for (size_t i = 0; i < backoff; i++)
+					cpuRelax();
+				backoff *= 2;
+			} else {
+				this_thread::yield();
+			}
+		}
+	}
+
+	if (begin >= end)
+		return nextStealing(participant, begin, end);
+
+	// Keep the low half, leave the high halves for thieves. Largest pieces end up on top where they are stolen first.
+	while (end - begin > _grainSize) {
+		size_t mid = begin + (end - begin) / 2;
+		p._deque.push(mid, end);
+		end = mid;
+	}
+
+	return true;
+}
+
+bool RangeScheduler::trySteal(size_t participant, size_t& begin, size_t& end)
+{
+	// Helpers that joined late have deques too
+	size_t numVictims = min(_numJoined.load(memory_order_relaxed), _maxParticipants);
+	if (numVictims < 2)
+		return false;
+
+	auto& p = _participants[participant];
+	p._rand ^= p._rand << 13;
+	p._rand ^= p._rand >> 7;
+	p._rand ^= p._rand << 17;
+
+	size_t start = (size_t)(p._rand % numVictims);
+	for (size_t i = 0; i < numVictims; i++) {
+		size_t victim = (start + i) % numVictims;
+		if (victim != participant && _participants[victim]._deque.steal(begin, end))
+			return true;
+	}
+	return false;
+}
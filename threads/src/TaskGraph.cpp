@@ -0,0 +1,196 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Copyright Robert R Tipton, 2022, all rights reserved except those granted in prior license statement.
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <assert.h>
+#include <TaskGraph.h>
+
+using namespace std;
+using namespace MultiCore;
+
+TaskGraph::TaskGraph(const ThreadPool& pool)
+	: _pool(pool)
+{
+}
+
+TaskGraph::~TaskGraph()
+{
+	// Queued tasks point at this graph. Throwing from a destructor terminates, a failure nobody waited for is dropped.
+	if (_running)
+		waitForNodes();
+}
+
+TaskGraph::NodeId TaskGraph::addNode(TaskType task, const vector<NodeId>& predecessors)
+{
+	NodeId id;
+	bool running;
+	{
+		lock_guard lg(_mutex);
+		id = _nodes.size();
+		auto& node = _nodes.emplace_back();
+		node._task = move(task);
+		for (NodeId pred : predecessors) {
+			assert(pred < id);
+			auto& predNode = _nodes[pred];
+			if (!predNode._done) {
+				predNode._successors.push_back(id);
+				node._numPending.fetch_add(1, memory_order_relaxed);
+			}
+		}
+		_numUnfinished.fetch_add(1, memory_order_acq_rel);
+
+		running = _running;
+		if (!running)
+			_unreleased.push_back(id);
+	}
+
+	if (running)
+		release(id);
+
+	return id;
+}
+
+void TaskGraph::addEdge(NodeId from, NodeId to)
+{
+	lock_guard lg(_mutex);
+	assert(from < _nodes.size() && to < _nodes.size());
+	assert(find(_unreleased.begin(), _unreleased.end(), to) != _unreleased.end());
+
+	auto& fromNode = _nodes[from];
+	if (!fromNode._done) {
+		fromNode._successors.push_back(to);
+		_nodes[to]._numPending.fetch_add(1, memory_order_relaxed);
+	}
+}
+
+void TaskGraph::run()
+{
+	vector<NodeId> toRelease;
+	{
+		lock_guard lg(_mutex);
+		_running = true;
+		toRelease.swap(_unreleased);
+	}
+
+	for (NodeId id : toRelease)
+		release(id);
+}
+
+void TaskGraph::wait()
+{
+	// Unreleased nodes count as unfinished, start them rather than wait for them forever
+	run();
+	waitForNodes();
+
+	exception_ptr pException;
+	{
+		lock_guard lg(_mutex);
+		_running = false;
+		pException.swap(_exception);
+		_failed.store(false, memory_order_relaxed);
+	}
+
+	if (pException)
+		rethrow_exception(pException);
+}
+
+void TaskGraph::runAndWait()
+{
+	run();
+	wait();
+}
+
+size_t TaskGraph::size() const
+{
+	lock_guard lg(_mutex);
+	return _nodes.size();
+}
+
+bool TaskGraph::isDone(NodeId id) const
+{
+	lock_guard lg(_mutex);
+	return _nodes[id]._done;
+}
+
+void TaskGraph::waitForNodes()
+{
+	size_t numUnfinished;
+	while ((numUnfinished = _numUnfinished.load(memory_order_acquire)) != 0) {
+		// Help with queued work, ours or anyone else's, before sleeping
+		if (!_pool.runPendingTask())
+			_numUnfinished.wait(numUnfinished, memory_order_acquire);
+	}
+}
+
+void TaskGraph::release(NodeId id)
+{
+	Node* pNode;
+	{
+		lock_guard lg(_mutex);
+		pNode = &_nodes[id];
+	}
+
+	if (pNode->_numPending.fetch_sub(1, memory_order_acq_rel) == 1) {
+		_pool.enqueue([this, id]() {
+			execute(id);
+		});
+	}
+}
+
+void TaskGraph::execute(NodeId id)
+{
+	Node* pNode;
+	{
+		lock_guard lg(_mutex);
+		pNode = &_nodes[id];
+	}
+
+	// After a failure the remaining nodes only count down, so wait() still returns
+	if (!_failed.load(memory_order_acquire)) {
+		try {
+			pNode->_task();
+		} catch (...) {
+			lock_guard lg(_mutex);
+			if (!_exception)
+				_exception = current_exception();
+			_failed.store(true, memory_order_release);
+		}
+	}
+
+	vector<NodeId> successors;
+	{
+		lock_guard lg(_mutex);
+		pNode->_done = true;
+		pNode->_task = nullptr;
+		successors.swap(pNode->_successors);
+	}
+
+	for (NodeId succ : successors)
+		release(succ);
+
+	if (_numUnfinished.fetch_sub(1, memory_order_acq_rel) == 1)
+		_numUnfinished.notify_all();
+}
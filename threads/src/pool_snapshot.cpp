@@ -0,0 +1,280 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Copyright Robert R Tipton, 2022, all rights reserved except those granted in prior license statement.
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+#include <defines.h>
+#include <assert.h>
+#include <string.h>
+#include <pool_snapshot.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+const char s_snapshotMagic[8] = { 'M', 'C', 'S', 'N', 'A', 'P', 0, 0 };
+
+}
+
+::MultiCore::mapped_file::~mapped_file()
+{
+	close();
+}
+
+bool ::MultiCore::mapped_file::open(const std::string& path)
+{
+	close();
+
+#if defined(_WIN32)
+	HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(hFile);
+		return false;
+	}
+
+	HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!hMapping) {
+		CloseHandle(hFile);
+		return false;
+	}
+
+	void* p = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (!p) {
+		CloseHandle(hMapping);
+		CloseHandle(hFile);
+		return false;
+	}
+
+	_hFile = hFile;
+	_hMapping = hMapping;
+	_pData = (const char*)p;
+	_size = (size_t)fileSize.QuadPart;
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+
+	void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (p == MAP_FAILED) {
+		::close(fd);
+		return false;
+	}
+
+	_fd = fd;
+	_pData = (const char*)p;
+	_size = (size_t)st.st_size;
+#endif
+
+	return true;
+}
+
+void ::MultiCore::mapped_file::close()
+{
+	if (!_pData)
+		return;
+
+#if defined(_WIN32)
+	UnmapViewOfFile(_pData);
+	CloseHandle((HANDLE)_hMapping);
+	CloseHandle((HANDLE)_hFile);
+	_hMapping = nullptr;
+	_hFile = nullptr;
+#else
+	munmap((void*)_pData, _size);
+	::close(_fd);
+	_fd = -1;
+#endif
+
+	_pData = nullptr;
+	_size = 0;
+}
+
+bool ::MultiCore::mapped_file::isOpen() const
+{
+	return _pData != nullptr;
+}
+
+const char* ::MultiCore::mapped_file::data() const
+{
+	return _pData;
+}
+
+size_t ::MultiCore::mapped_file::size() const
+{
+	return _size;
+}
+
+/*************************************************************************************************/
+
+::MultiCore::snapshot_writer::~snapshot_writer()
+{
+	if (_out.is_open())
+		close();
+}
+
+bool ::MultiCore::snapshot_writer::open(const std::string& path)
+{
+	_entries.clear();
+	_out.open(path, std::ios::binary | std::ios::trunc);
+	if (!_out.is_open())
+		return false;
+
+	// Placeholder, rewritten by close() once the directory offset is known
+	snapshot_file_header header;
+	memset(&header, 0, sizeof(header));
+	_out.write((const char*)&header, sizeof(header));
+
+	return _out.good();
+}
+
+bool ::MultiCore::snapshot_writer::close()
+{
+	if (!_out.is_open())
+		return false;
+
+	snapshot_file_header header;
+	memcpy(header._magic, s_snapshotMagic, sizeof(header._magic));
+	header._version = SNAPSHOT_VERSION;
+	header._numEntries = (uint32_t)_entries.size();
+	header._dirOffset = alignOutput();
+	if (!_entries.empty())
+		_out.write((const char*)_entries.data(), _entries.size() * sizeof(snapshot_entry));
+
+	_out.seekp(0);
+	_out.write((const char*)&header, sizeof(header));
+
+	bool result = _out.good();
+	_out.close();
+	_entries.clear();
+
+	return result;
+}
+
+uint64_t MultiCore::snapshot_writer::alignOutput()
+{
+	uint64_t pos = (uint64_t)_out.tellp();
+	uint64_t alignedPos = (pos + SNAPSHOT_ALIGNMENT - 1) & ~((uint64_t)SNAPSHOT_ALIGNMENT - 1);
+	static const char zeros[SNAPSHOT_ALIGNMENT] = {};
+	if (alignedPos > pos)
+		_out.write(zeros, (std::streamsize)(alignedPos - pos));
+	return alignedPos;
+}
+
+uint64_t MultiCore::snapshot_writer::writeArray(const void* pData, size_t numBytes)
+{
+	if (!_out.is_open())
+		return 0;
+
+	uint64_t offset = alignOutput();
+	if (numBytes > 0)
+		_out.write((const char*)pData, (std::streamsize)numBytes);
+
+	return _out.good() ? offset : 0;
+}
+
+/*************************************************************************************************/
+
+bool ::MultiCore::snapshot_reader::open(const std::string& path)
+{
+	close();
+
+	auto pFile = std::make_shared<mapped_file>();
+	if (!pFile->open(path))
+		return false;
+
+	if (pFile->size() < sizeof(snapshot_file_header))
+		return false;
+
+	const snapshot_file_header* pHeader = (const snapshot_file_header*)pFile->data();
+	if (memcmp(pHeader->_magic, s_snapshotMagic, sizeof(pHeader->_magic)) != 0 || pHeader->_version != SNAPSHOT_VERSION)
+		return false;
+
+	_pFile = pFile;
+	if (!isRangeValid(pHeader->_dirOffset, pHeader->_numEntries * sizeof(snapshot_entry))) {
+		_pFile.reset();
+		return false;
+	}
+
+	_pEntries = (const snapshot_entry*)(_pFile->data() + pHeader->_dirOffset);
+	_numEntries = pHeader->_numEntries;
+
+	return true;
+}
+
+void ::MultiCore::snapshot_reader::close()
+{
+	// Views handed out hold their own reference to the mapping, it stays valid until they are done with it
+	_pFile.reset();
+	_pEntries = nullptr;
+	_numEntries = 0;
+}
+
+size_t ::MultiCore::snapshot_reader::getNumEntries() const
+{
+	return _numEntries;
+}
+
+const ::MultiCore::snapshot_entry* ::MultiCore::snapshot_reader::getEntry(size_t entryNum, uint32_t kind, size_t keySize, size_t valSize) const
+{
+	if (entryNum >= _numEntries)
+		return nullptr;
+
+	const snapshot_entry* pEntry = &_pEntries[entryNum];
+	if (pEntry->_kind != kind || pEntry->_keySize != keySize || pEntry->_valSize != valSize)
+		return nullptr;
+
+	if (keySize > 0 && !isRangeValid(pEntry->_keyOffset, pEntry->_count * keySize))
+		return nullptr;
+	if (valSize > 0 && !isRangeValid(pEntry->_valOffset, pEntry->_count * valSize))
+		return nullptr;
+
+	return pEntry;
+}
+
+bool ::MultiCore::snapshot_reader::isRangeValid(uint64_t offset, size_t numBytes) const
+{
+	if (!_pFile)
+		return false;
+	size_t fileSize = _pFile->size();
+	return offset <= fileSize && numBytes <= fileSize - offset;
+}
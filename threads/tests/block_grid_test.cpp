@@ -0,0 +1,150 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// MultiCore::block_grid halo exchange and block indexing.
+// Fills a grid whose extent isn't a multiple of the block size, exchanges halos and checks every halo cell inside the
+// domain, faces, edges and corners, against the owning block's interior cell. Halo cells outside the domain must be
+// left alone, and runBlocks must run each block with its own heap as the thread heap. Returns non zero on failure.
+
+#include <stdlib.h>
+#include <atomic>
+#include <iostream>
+#include <block_grid.h>
+
+using namespace std;
+
+namespace
+{
+
+int s_numFailures = 0;
+
+void check(bool cond, const char* pMsg)
+{
+	if (!cond) {
+		cout << "FAILED: " << pMsg << "\n";
+		s_numFailures++;
+	}
+}
+
+const size_t s_outside = (size_t)-1;
+
+size_t cellValue(int64_t i, int64_t j, int64_t k)
+{
+	return (size_t)((k * 1000 + j) * 1000 + i);
+}
+
+void testGrid(const MultiCore::ThreadPool& pool, size_t nx, size_t ny, size_t nz, size_t blockSize, size_t haloWidth)
+{
+	using Grid = MultiCore::block_grid<size_t>;
+	Grid grid(nx, ny, nz, blockSize, haloWidth);
+	const size_t numCells[] = { nx, ny, nz };
+	for (int axis = 0; axis < 3; axis++)
+		check(grid.getNumBlocks(axis) == (numCells[axis] + blockSize - 1) / blockSize, "block count rounds up");
+
+	const int h = (int)haloWidth;
+	const int bs = (int)blockSize;
+	auto inDomain = [&numCells](const Grid::Block& blk, int i, int j, int k)->bool {
+		const int local[] = { i, j, k };
+		for (int axis = 0; axis < 3; axis++) {
+			int64_t g = (int64_t)blk.getOrigin(axis) + local[axis];
+			if (g < 0 || g >= (int64_t)numCells[axis])
+				return false;
+		}
+		return true;
+	};
+
+	// Interior cells get their global coordinates, halos a marker
+	atomic<size_t> numWrongHeap = 0;
+	grid.runBlocks(pool, [&](Grid::Block& blk)->bool {
+		if (MultiCore::local_heap::getThreadHeapPtr() != &blk.getHeap())
+			numWrongHeap++;
+		for (int k = -h; k < bs + h; k++) {
+			for (int j = -h; j < bs + h; j++) {
+				for (int i = -h; i < bs + h; i++) {
+					bool interior = i >= 0 && i < bs && j >= 0 && j < bs && k >= 0 && k < bs;
+					blk(i, j, k) = interior && inDomain(blk, i, j, k)
+						? cellValue(blk.getOrigin(0) + i, blk.getOrigin(1) + j, blk.getOrigin(2) + k) : s_outside;
+				}
+			}
+		}
+		return true;
+	}, true);
+	check(numWrongHeap == 0, "runBlocks sets the block's heap as the thread heap");
+
+	bool globalOk = true;
+	for (size_t k = 0; k < nz; k++) {
+		for (size_t j = 0; j < ny; j++) {
+			for (size_t i = 0; i < nx; i++)
+				globalOk = globalOk && grid(i, j, k) == cellValue(i, j, k);
+		}
+	}
+	check(globalOk, "global indexing reaches the owning block's interior");
+
+	grid.exchangeHalos(pool, true);
+
+	bool haloOk = true, outsideOk = true, interiorOk = true;
+	size_t numHaloChecked = 0;
+	for (size_t blockIdx = 0; blockIdx < grid.getNumBlocks(); blockIdx++) {
+		const Grid::Block& blk = grid.getBlock(blockIdx);
+		for (int k = -h; k < bs + h; k++) {
+			for (int j = -h; j < bs + h; j++) {
+				for (int i = -h; i < bs + h; i++) {
+					bool interior = i >= 0 && i < bs && j >= 0 && j < bs && k >= 0 && k < bs;
+					size_t expected = cellValue(blk.getOrigin(0) + i, blk.getOrigin(1) + j, blk.getOrigin(2) + k);
+					if (!inDomain(blk, i, j, k)) {
+						outsideOk = outsideOk && blk(i, j, k) == s_outside;
+					} else if (interior) {
+						interiorOk = interiorOk && blk(i, j, k) == expected;
+					} else {
+						haloOk = haloOk && blk(i, j, k) == expected;
+						numHaloChecked++;
+					}
+				}
+			}
+		}
+	}
+	if (grid.getNumBlocks() > 1)
+		check(numHaloChecked > 0, "some halo cells are inside the domain");
+	check(haloOk, "halo cells match the neighbour's interior, faces, edges and corners");
+	check(interiorOk, "exchange doesn't touch interiors");
+	check(outsideOk, "halo cells outside the domain are left alone");
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	MultiCore::ThreadPool pool(4, 4, 4);
+
+	testGrid(pool, 16, 16, 16, 8, 1);
+	testGrid(pool, 19, 13, 10, 4, 1);
+	testGrid(pool, 19, 13, 10, 4, 2);
+	testGrid(pool, 7, 5, 3, 8, 1);
+
+	cout << (s_numFailures == 0 ? "PASSED\n" : "FAILED\n");
+	return s_numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,121 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// MultiCore::concurrent_unordered_map with a seeded hasher and with keys that are multiples of a large power of 2.
+// Every entry must still be found after the stripes have rehashed many times, filled from one thread and from many.
+// Returns non zero on failure.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#include <iostream>
+#include <MultiCoreUtil.h>
+#include <concurrent_unordered_map.h>
+
+using namespace std;
+using namespace MultiCore;
+
+namespace
+{
+
+int s_numFailures = 0;
+
+void check(bool cond, const char* pMsg)
+{
+	if (!cond) {
+		cout << "FAILED: " << pMsg << "\n";
+		s_numFailures++;
+	}
+}
+
+// Each instance has a different seed, a default constructed copy would hash differently
+struct SeededHash {
+	SeededHash(uint64_t seed = 0)
+		: _seed(seed)
+	{
+	}
+
+	size_t operator()(size_t key) const
+	{
+		return (size_t)(key ^ _seed);
+	}
+
+	uint64_t _seed;
+};
+
+template<class MAP>
+void checkContents(const MAP& map, size_t numKeys, size_t stride, const char* pMsg)
+{
+	bool ok = map.size() == numKeys;
+	for (size_t i = 0; i < numKeys && ok; i++) {
+		size_t val;
+		ok = map.find(i * stride, val) && val == i;
+	}
+	check(ok, pMsg);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const size_t numKeys = 20000;
+	const size_t stride = 1024;
+
+	{
+		concurrent_unordered_map<size_t, size_t, SeededHash> map(8, 1, SeededHash(0x5DEECE66Dull));
+		for (size_t i = 0; i < numKeys; i++)
+			map.insert(i * stride, i);
+		checkContents(map, numKeys, stride, "seeded hasher after rehash");
+
+		for (size_t i = 0; i < numKeys; i += 2)
+			map.erase(i * stride);
+		bool ok = map.size() == numKeys / 2;
+		for (size_t i = 0; i < numKeys && ok; i++)
+			ok = map.contains(i * stride) == (i % 2 == 1);
+		check(ok, "seeded hasher erase");
+	}
+
+	{
+		concurrent_unordered_map<size_t, size_t> map(16, 1);
+		getGlobalPool().run(numKeys, [&map, stride](size_t threadNum, size_t i)->bool {
+			map.insert(i * stride, i);
+			return true;
+		}, true);
+		checkContents(map, numKeys, stride, "parallel insert of strided keys");
+	}
+
+	{
+		concurrent_unordered_map<size_t, size_t> map(1, 1);
+		for (size_t i = 0; i < numKeys; i++)
+			map.insert(i * stride, i);
+		checkContents(map, numKeys, stride, "single stripe");
+	}
+
+	shutdown();
+	cout << (s_numFailures == 0 ? "PASSED\n" : "FAILED\n");
+	return s_numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
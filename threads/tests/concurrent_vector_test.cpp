@@ -0,0 +1,101 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// MultiCore::concurrent_vector appended to from several threads at once.
+// Every entry must land once, and capacity() must cover size() whichever order the segments were installed in.
+// Returns non zero on failure.
+
+#include <stdlib.h>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <concurrent_vector.h>
+#include <MultiCoreUtil.h>
+
+using namespace std;
+
+namespace
+{
+
+int s_numFailures = 0;
+
+void check(bool cond, const char* pMsg)
+{
+	if (!cond) {
+		cout << "FAILED: " << pMsg << "\n";
+		s_numFailures++;
+	}
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const size_t numSteps = 10000;
+	const size_t numPerGrow = 37;
+	MultiCore::ThreadPool pool(4, 4, 4);
+
+	{
+		MultiCore::local_heap heap(1024);
+		MultiCore::concurrent_vector<size_t> vec(&heap);
+		check(vec.capacity() == 0, "empty vector has no capacity");
+
+		pool.run(numSteps, [&vec](size_t, size_t i)->bool {
+			if (i % 2 == 0) {
+				vec.push_back(i);
+			} else {
+				size_t start = vec.grow_by(numPerGrow);
+				for (size_t j = 0; j < numPerGrow; j++)
+					vec[start + j] = i;
+			}
+			return true;
+		}, true);
+
+		const size_t numOdd = numSteps / 2;
+		check(vec.size() == numSteps - numOdd + numOdd * numPerGrow, "size counts every push_back and grow_by");
+		check(vec.capacity() >= vec.size(), "capacity covers size");
+
+		vector<size_t> counts(numSteps, 0);
+		for (size_t i = 0; i < vec.size(); i++)
+			counts[vec[i]]++;
+		bool allLanded = true;
+		for (size_t i = 0; i < numSteps; i++)
+			allLanded = allLanded && counts[i] == (i % 2 == 0 ? 1 : numPerGrow);
+		check(allLanded, "every entry lands once");
+	}
+
+	{
+		// reserve installs the segments up front, capacity reports the end of the highest one
+		MultiCore::local_heap heap(1024);
+		MultiCore::concurrent_vector<size_t> vec(&heap);
+		vec.reserve(100000);
+		check(vec.capacity() >= 100000 && vec.empty(), "reserve sets capacity, not size");
+	}
+
+	cout << (s_numFailures == 0 ? "PASSED\n" : "FAILED\n");
+	return s_numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,168 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// MultiCore::task, when_all and syncWait on a ThreadPool.
+// Results must come back from vector and tuple when_all, exceptions must reach co_await and syncWait, and thousands of
+// coroutines suspended on pool.schedule() must all finish on a small pool. Returns non zero on failure.
+
+#include <stdlib.h>
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <MultiCoreUtil.h>
+
+using namespace std;
+
+namespace
+{
+
+int s_numFailures = 0;
+
+void check(bool cond, const char* pMsg)
+{
+	if (!cond) {
+		cout << "FAILED: " << pMsg << "\n";
+		s_numFailures++;
+	}
+}
+
+MultiCore::task<int> square(const MultiCore::ThreadPool& pool, int v)
+{
+	co_await pool.schedule();
+	co_return v * v;
+}
+
+MultiCore::task<> count(const MultiCore::ThreadPool& pool, atomic<int>& numRun)
+{
+	co_await pool.schedule();
+	numRun++;
+}
+
+MultiCore::task<int> ready()
+{
+	co_return 7;
+}
+
+MultiCore::task<int> fail(const MultiCore::ThreadPool& pool)
+{
+	co_await pool.schedule();
+	throw runtime_error("task failed");
+}
+
+MultiCore::task<long> sumSquares(const MultiCore::ThreadPool& pool, int numTasks)
+{
+	co_await pool.schedule();
+	vector<MultiCore::task<int>> tasks;
+	for (int i = 0; i < numTasks; i++)
+		tasks.push_back(square(pool, i % 100));
+
+	auto results = co_await MultiCore::when_all(move(tasks));
+	long sum = 0;
+	for (int v : results)
+		sum += v;
+	co_return sum;
+}
+
+MultiCore::task<int> tupleOf(const MultiCore::ThreadPool& pool, atomic<int>& numRun)
+{
+	auto [a, b, c] = co_await MultiCore::when_all(square(pool, 3), count(pool, numRun), ready());
+	co_return a + c;
+}
+
+MultiCore::task<string> catchFailures(const MultiCore::ThreadPool& pool)
+{
+	string caught;
+	try {
+		co_await fail(pool);
+	} catch (const runtime_error&) {
+		caught += "task";
+	}
+
+	try {
+		co_await MultiCore::when_all(square(pool, 1), fail(pool));
+	} catch (const runtime_error&) {
+		caught += ",when_all";
+	}
+
+	vector<MultiCore::task<int>> none;
+	auto empty = co_await MultiCore::when_all(move(none));
+	if (empty.empty())
+		caught += ",empty";
+	co_return caught;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	MultiCore::ThreadPool pool(4, 4, 4);
+
+	{
+		const int numTasks = 5000;
+		long expected = 0;
+		for (int i = 0; i < numTasks; i++)
+			expected += (i % 100) * (i % 100);
+		check(MultiCore::syncWait(pool, sumSquares(pool, numTasks)) == expected, "vector when_all over many suspended tasks");
+	}
+
+	{
+		atomic<int> numRun = 0;
+		check(MultiCore::syncWait(pool, tupleOf(pool, numRun)) == 16, "tuple when_all results");
+		check(numRun == 1, "void task in a tuple when_all runs");
+	}
+
+	check(MultiCore::syncWait(pool, ready()) == 7, "syncWait on a task that never suspends");
+	check(MultiCore::syncWait(pool, catchFailures(pool)) == "task,when_all,empty", "exceptions reach co_await");
+
+	{
+		bool caught = false;
+		try {
+			MultiCore::syncWait(pool, fail(pool));
+		} catch (const runtime_error&) {
+			caught = true;
+		}
+		check(caught, "syncWait rethrows");
+	}
+
+	{
+		// Lazily started, nothing runs until awaited
+		atomic<int> numRun = 0;
+		{
+			auto unawaited = count(pool, numRun);
+		}
+		auto awaited = count(pool, numRun);
+		check(numRun == 0, "task doesn't start before it is awaited");
+		MultiCore::syncWait(pool, move(awaited));
+		check(numRun == 1, "task runs once awaited");
+	}
+
+	cout << (s_numFailures == 0 ? "PASSED\n" : "FAILED\n");
+	return s_numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,107 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// MultiCore::cow_vector insert and erase on a buffer shared with a snapshot.
+// The edited vector must detach and get the expected contents, the snapshot must be unchanged. Returns non zero on
+// failure.
+
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include <cow_vector.h>
+
+using namespace std;
+
+namespace
+{
+
+int s_numFailures = 0;
+
+void check(bool cond, const char* pMsg)
+{
+	if (!cond) {
+		cout << "FAILED: " << pMsg << "\n";
+		s_numFailures++;
+	}
+}
+
+bool equals(const MultiCore::cow_vector<int>& vec, const vector<int>& expected)
+{
+	if (vec.size() != expected.size())
+		return false;
+	for (size_t i = 0; i < expected.size(); i++) {
+		if (vec[i] != expected[i])
+			return false;
+	}
+	return true;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const vector<int> original = { 0, 1, 2, 3, 4, 5, 6, 7 };
+
+	{
+		MultiCore::cow_vector<int> vec(original);
+		MultiCore::cow_vector<int> snapshot(vec);
+		check(vec.isShared(), "copy shares the buffer");
+
+		const MultiCore::cow_vector<int>& cvec = vec;
+		auto iter = vec.insert(cvec.begin() + 3, 100);
+		check(!vec.isShared() && !snapshot.isShared(), "insert detaches");
+		check(*iter == 100, "insert returns the new entry");
+		check(equals(vec, { 0, 1, 2, 100, 3, 4, 5, 6, 7 }), "insert into shared buffer");
+		check(equals(snapshot, original), "snapshot unchanged by insert");
+	}
+
+	{
+		MultiCore::cow_vector<int> vec(original);
+		MultiCore::cow_vector<int> snapshot(vec);
+		const MultiCore::cow_vector<int>& cvec = vec;
+		vec.insert(cvec.end(), 8);
+		check(equals(vec, { 0, 1, 2, 3, 4, 5, 6, 7, 8 }), "insert at end of shared buffer");
+		check(equals(snapshot, original), "snapshot unchanged by insert at end");
+	}
+
+	{
+		MultiCore::cow_vector<int> vec(original);
+		MultiCore::cow_vector<int> snapshot(vec);
+		const MultiCore::cow_vector<int>& cvec = vec;
+		vec.erase(cvec.begin() + 2, cvec.begin() + 5);
+		check(equals(vec, { 0, 1, 5, 6, 7 }), "range erase from shared buffer");
+		check(equals(snapshot, original), "snapshot unchanged by range erase");
+
+		MultiCore::cow_vector<int> snapshot2(vec);
+		vec.erase(cvec.begin());
+		check(equals(vec, { 1, 5, 6, 7 }), "erase from shared buffer");
+		check(equals(snapshot2, { 0, 1, 5, 6, 7 }), "second snapshot unchanged by erase");
+	}
+
+	cout << (s_numFailures == 0 ? "PASSED\n" : "FAILED\n");
+	return s_numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
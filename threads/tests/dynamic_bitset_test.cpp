@@ -0,0 +1,160 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// MultiCore::dynamic_bitset against a std::vector<bool> reference.
+// Sizes on and around word boundaries, random bits, bulk operations, scans and resizes must all agree with the
+// reference, and bits past size() must never be counted. Returns non zero on failure.
+
+#include <stdlib.h>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <dynamic_bitset.h>
+
+using namespace std;
+
+namespace
+{
+
+int s_numFailures = 0;
+
+void check(bool cond, const char* pMsg)
+{
+	if (!cond) {
+		cout << "FAILED: " << pMsg << "\n";
+		s_numFailures++;
+	}
+}
+
+bool matches(const MultiCore::dynamic_bitset& bits, const vector<bool>& ref)
+{
+	if (bits.size() != ref.size())
+		return false;
+
+	size_t numSet = 0;
+	for (size_t i = 0; i < ref.size(); i++) {
+		if (bits.test(i) != ref[i])
+			return false;
+		if (ref[i])
+			numSet++;
+	}
+	if (bits.count() != numSet || bits.any() != (numSet > 0) || bits.all() != (numSet == ref.size()))
+		return false;
+
+	// find_first/find_next and for_each_set visit the same bits in order
+	vector<size_t> found, visited;
+	for (size_t idx = bits.find_first(); idx != MultiCore::dynamic_bitset::npos; idx = bits.find_next(idx))
+		found.push_back(idx);
+	bits.for_each_set([&visited](size_t idx) {
+		visited.push_back(idx);
+	});
+	if (found.size() != numSet || found != visited)
+		return false;
+	for (size_t idx : found) {
+		if (!ref[idx])
+			return false;
+	}
+	return true;
+}
+
+void randomize(MultiCore::dynamic_bitset& bits, vector<bool>& ref, mt19937& rng, unsigned percent)
+{
+	for (size_t i = 0; i < ref.size(); i++) {
+		bool val = rng() % 100 < percent;
+		bits.set(i, val);
+		ref[i] = val;
+	}
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	mt19937 rng(12345);
+
+	for (size_t numBits : { 0, 1, 63, 64, 65, 127, 128, 129, 1000, 4099 }) {
+		MultiCore::dynamic_bitset a(numBits), b(numBits);
+		vector<bool> refA(numBits), refB(numBits);
+		check(matches(a, refA), "starts clear");
+
+		randomize(a, refA, rng, 30);
+		randomize(b, refB, rng, 70);
+		check(matches(a, refA) && matches(b, refB), "set and test");
+
+		auto c = a;
+		c &= b;
+		vector<bool> ref(numBits);
+		for (size_t i = 0; i < numBits; i++)
+			ref[i] = refA[i] && refB[i];
+		check(matches(c, ref), "and");
+
+		c = a;
+		c |= b;
+		for (size_t i = 0; i < numBits; i++)
+			ref[i] = refA[i] || refB[i];
+		check(matches(c, ref), "or");
+
+		c = a;
+		c ^= b;
+		for (size_t i = 0; i < numBits; i++)
+			ref[i] = refA[i] != refB[i];
+		check(matches(c, ref), "xor");
+
+		c = a;
+		c.and_not(b);
+		for (size_t i = 0; i < numBits; i++)
+			ref[i] = refA[i] && !refB[i];
+		check(matches(c, ref), "and_not");
+		check((c == a) == (ref == refA), "equality");
+
+		c.set();
+		check(matches(c, vector<bool>(numBits, true)), "set all keeps the tail clear");
+		c.reset();
+		check(matches(c, vector<bool>(numBits, false)), "reset all");
+
+		if (numBits > 0) {
+			c.flip(numBits - 1);
+			check(c.find_first() == numBits - 1 && c.count() == 1, "flip the last bit");
+		}
+
+		// Growing with set bits must not pick up anything left in the old tail
+		c = a;
+		ref = refA;
+		c.resize(numBits + 70, true);
+		ref.resize(numBits + 70, true);
+		check(matches(c, ref), "resize up with set bits");
+		c.resize(numBits / 2);
+		ref.resize(numBits / 2);
+		check(matches(c, ref), "resize down clears the tail");
+		c.resize(numBits);
+		ref.resize(numBits, false);
+		check(matches(c, ref), "resize up again with clear bits");
+	}
+
+	cout << (s_numFailures == 0 ? "PASSED\n" : "FAILED\n");
+	return s_numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
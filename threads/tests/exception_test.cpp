@@ -0,0 +1,139 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// Exceptions thrown from the function passed to MultiCore::ThreadPool run, runSub and runLambda.
+// The first exception must reach the caller for every partitioner, from nested runs too, the run must stop early and
+// the pool must still run afterwards. Returns non zero on failure.
+
+#include <stdlib.h>
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <MultiCoreUtil.h>
+
+using namespace std;
+
+namespace
+{
+
+int s_numFailures = 0;
+
+void check(bool cond, const char* pMsg)
+{
+	if (!cond) {
+		cout << "FAILED: " << pMsg << "\n";
+		s_numFailures++;
+	}
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const size_t numSteps = 100000;
+	MultiCore::ThreadPool pool(4, 4, 4);
+
+	const MultiCore::Partitioner parts[] = {
+		MultiCore::Partitioner::strided(),
+		MultiCore::Partitioner::staticBlocks(),
+		MultiCore::Partitioner::dynamic(),
+		MultiCore::Partitioner::guided(),
+		MultiCore::Partitioner::stealing(),
+	};
+
+	for (const auto& part : parts) {
+		atomic<size_t> numRun = 0;
+		bool caught = false;
+		try {
+			pool.run(numSteps, [&numRun](size_t threadNum, size_t i)->bool {
+				numRun++;
+				if (i == 500)
+					throw runtime_error("run failed");
+				return true;
+			}, true, part);
+		} catch (const runtime_error&) {
+			caught = true;
+		}
+		check(caught, "run rethrows");
+		check(numRun < numSteps, "run stops after an exception");
+
+		caught = false;
+		try {
+			pool.run(8, [&pool, &part](size_t threadNum, size_t i)->bool {
+				pool.runSub(1000, 1, [](size_t threadNum, size_t j)->bool {
+					if (j == 300)
+						throw 42;
+					return true;
+				}, true, part);
+				return true;
+			}, true, part);
+		} catch (int v) {
+			caught = v == 42;
+		}
+		check(caught, "nested runSub rethrows through the outer run");
+	}
+
+	{
+		bool caught = false;
+		try {
+			MultiCore::runLambda([](size_t i)->bool {
+				if (i == 5)
+					throw logic_error("runLambda failed");
+				return true;
+			}, 100, true);
+		} catch (const logic_error&) {
+			caught = true;
+		}
+		check(caught, "runLambda rethrows");
+
+		caught = false;
+		try {
+			MultiCore::runLambda(8, [](size_t threadNum, size_t numThreads) {
+				if (threadNum == numThreads - 1)
+					throw logic_error("runLambda(numCores) failed");
+			}, true);
+		} catch (const logic_error&) {
+			caught = true;
+		}
+		check(caught, "runLambda(numCores) rethrows");
+	}
+
+	{
+		atomic<size_t> numRun = 0;
+		pool.run(1000, [&numRun](size_t threadNum, size_t i)->bool {
+			numRun++;
+			return true;
+		}, true);
+		check(numRun == 1000, "pool runs every step after exceptions");
+	}
+
+	MultiCore::shutdown();
+
+	cout << (s_numFailures == 0 ? "PASSED\n" : "FAILED\n");
+	return s_numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,118 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// MultiCore::PoolFuture results that are move only or expensive to copy.
+// get() must hand out the stored result by reference, take() must move it out, and then() must pass it on without
+// copying it. Returns non zero on failure.
+
+#include <stdlib.h>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <PoolFuture.h>
+
+using namespace std;
+
+namespace
+{
+
+int s_numFailures = 0;
+
+void check(bool cond, const char* pMsg)
+{
+	if (!cond) {
+		cout << "FAILED: " << pMsg << "\n";
+		s_numFailures++;
+	}
+}
+
+atomic<int> s_numCopies = 0;
+
+struct Counted {
+	Counted(int v)
+		: _v(v)
+	{
+	}
+
+	Counted(const Counted& src)
+		: _v(src._v)
+	{
+		s_numCopies++;
+	}
+
+	Counted(Counted&& src) = default;
+
+	int _v;
+};
+
+}
+
+int main(int argc, char** argv)
+{
+	MultiCore::ThreadPool pool(2, 2, 2);
+
+	{
+		auto fut = pool.submit([]() {
+			return make_unique<int>(42);
+		});
+		const auto& p = fut.get();
+		check(p && *p == 42, "get of a move only result");
+		auto owned = fut.take();
+		check(owned && *owned == 42, "take moves a move only result out");
+		check(!fut.get(), "get after take sees the moved from value");
+	}
+
+	{
+		s_numCopies = 0;
+		auto fut = pool.submit([]() {
+			return Counted(7);
+		});
+		auto next = fut.then([](const Counted& c) {
+			return c._v + 1;
+		});
+		check(&fut.get() == &fut.get() && fut.get()._v == 7, "get returns the stored result");
+		check(next.get() == 8, "then gets the result");
+		check(s_numCopies == 0, "neither get nor then copies the result");
+	}
+
+	{
+		auto fut = pool.submit([]()->unique_ptr<int> {
+			throw runtime_error("task failed");
+		});
+		bool caught = false;
+		try {
+			fut.take();
+		} catch (const runtime_error&) {
+			caught = true;
+		}
+		check(caught, "take rethrows");
+	}
+
+	cout << (s_numFailures == 0 ? "PASSED\n" : "FAILED\n");
+	return s_numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
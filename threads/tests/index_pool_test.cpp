@@ -0,0 +1,115 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// MultiCore::runLambda over an index pool, with threads that stop part way through a batch.
+// Each entry must either be run once or be left in the pool, and a thread must not run again after it stopped.
+// Returns non zero on failure.
+
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include <MultiCoreUtil.h>
+
+using namespace std;
+
+namespace
+{
+
+int s_numFailures = 0;
+
+void check(bool cond, const char* pMsg)
+{
+	if (!cond) {
+		cout << "FAILED: " << pMsg << "\n";
+		s_numFailures++;
+	}
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const size_t numEntries = 1000;
+	const size_t numThreads = 4;
+	MultiCore::configureGlobalPool(numThreads);
+
+	for (size_t batchSize : { 1, 7, 64 }) {
+		vector<size_t> indexPool;
+		for (size_t i = 0; i < numEntries; i++)
+			indexPool.push_back(i % 10 == 3 ? (size_t)-1 : i);
+
+		mutex runMutex;
+		vector<size_t> run;
+		atomic<size_t> numStops = 0;
+		MultiCore::runLambda([&](size_t index)->bool {
+			lock_guard lg(runMutex);
+			run.push_back(index);
+			if (index % 97 == 0) {
+				numStops++;
+				return false;
+			}
+			return true;
+		}, indexPool, true, batchSize);
+
+		check(numStops <= numThreads, "a stopped thread doesn't run again");
+
+		vector<size_t> seen = run;
+		for (size_t index : indexPool) {
+			if (index != (size_t)-1)
+				seen.push_back(index);
+		}
+		sort(seen.begin(), seen.end());
+
+		vector<size_t> expected;
+		for (size_t i = 0; i < numEntries; i++) {
+			if (i % 10 != 3)
+				expected.push_back(i);
+		}
+		check(seen == expected, "every entry is run once or left in the pool");
+	}
+
+	{
+		vector<size_t> indexPool;
+		for (size_t i = 0; i < numEntries; i++)
+			indexPool.push_back(i);
+
+		atomic<size_t> numRun = 0;
+		MultiCore::runLambda([&numRun](size_t index)->bool {
+			numRun++;
+			return true;
+		}, indexPool, true, 16);
+		check(numRun == numEntries && indexPool.empty(), "pool is consumed when no thread stops");
+	}
+
+	MultiCore::shutdown();
+
+	cout << (s_numFailures == 0 ? "PASSED\n" : "FAILED\n");
+	return s_numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,124 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// MultiCore parallel_reduce, parallel_inclusive_scan, parallel_exclusive_scan and parallel_for_each.
+// Results must match a serial reference for sizes around the block size, scans must work in place, and float
+// reductions must give bit identical results single and multi core. Returns non zero on failure.
+
+#include <stdlib.h>
+#include <atomic>
+#include <iostream>
+#include <vector>
+#include <parallel_algorithm.h>
+
+using namespace std;
+
+namespace
+{
+
+int s_numFailures = 0;
+
+void check(bool cond, const char* pMsg)
+{
+	if (!cond) {
+		cout << "FAILED: " << pMsg << "\n";
+		s_numFailures++;
+	}
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	MultiCore::ThreadPool pool(4, 4, 4);
+	const size_t blockSize = 64;
+	auto add = [](size_t lhs, size_t rhs) {
+		return lhs + rhs;
+	};
+
+	for (size_t num : { 0, 1, 63, 64, 65, 1000, 10007 }) {
+		vector<size_t> in(num);
+		for (size_t i = 0; i < num; i++)
+			in[i] = (i * 7919) % 101;
+
+		size_t expectedSum = 0;
+		vector<size_t> inclusive(num), exclusive(num);
+		for (size_t i = 0; i < num; i++) {
+			exclusive[i] = 10 + expectedSum;
+			expectedSum += in[i];
+			inclusive[i] = expectedSum;
+		}
+
+		size_t sum = MultiCore::parallel_reduce(pool, in.data(), in.data() + num, (size_t)0, add, true, blockSize);
+		check(sum == expectedSum, "reduce over a range");
+		size_t mapped = MultiCore::parallel_reduce(pool, num, (size_t)0, [&in](size_t i) {
+			return in[i] * 2;
+		}, add, true, blockSize);
+		check(mapped == expectedSum * 2, "reduce over mapped indices");
+
+		vector<size_t> out(num);
+		MultiCore::parallel_inclusive_scan(pool, in.data(), in.data() + num, out.data(), add, true, blockSize);
+		check(out == inclusive, "inclusive scan");
+		MultiCore::parallel_exclusive_scan(pool, in.data(), in.data() + num, out.data(), (size_t)10, add, true, blockSize);
+		check(out == exclusive, "exclusive scan");
+
+		vector<size_t> inPlace = in;
+		MultiCore::parallel_inclusive_scan(pool, inPlace.data(), inPlace.data() + num, inPlace.data(), add, true, blockSize);
+		check(inPlace == inclusive, "inclusive scan in place");
+		inPlace = in;
+		MultiCore::parallel_exclusive_scan(pool, inPlace.data(), inPlace.data() + num, inPlace.data(), (size_t)10, add, true, blockSize);
+		check(inPlace == exclusive, "exclusive scan in place");
+
+		vector<atomic<int>> visits(num);
+		MultiCore::parallel_for_each(pool, visits, [](atomic<int>& v) {
+			v++;
+		}, true, blockSize);
+		bool once = true;
+		for (const auto& v : visits)
+			once = once && v == 1;
+		check(once, "for_each visits every entry once");
+	}
+
+	{
+		// Float addition isn't associative, the result may only depend on the data and the block size
+		vector<float> vals(100000);
+		for (size_t i = 0; i < vals.size(); i++)
+			vals[i] = 1.0f / (float)(i + 1) * ((i % 3) == 0 ? -1.0f : 1.0f) * 1e3f;
+		auto fadd = [](float lhs, float rhs) {
+			return lhs + rhs;
+		};
+		float multi = MultiCore::parallel_reduce(pool, vals, 0.0f, fadd, true);
+		float single = MultiCore::parallel_reduce(pool, vals, 0.0f, fadd, false);
+		bool same = true;
+		for (int rep = 0; rep < 10; rep++)
+			same = same && MultiCore::parallel_reduce(pool, vals, 0.0f, fadd, true) == multi;
+		check(multi == single && same, "float reduce is deterministic");
+	}
+
+	cout << (s_numFailures == 0 ? "PASSED\n" : "FAILED\n");
+	return s_numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
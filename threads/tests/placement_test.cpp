@@ -0,0 +1,96 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// MultiCore::ThreadPool built with PlacementOptions that leave one cpu or none.
+// One cpu belongs to the caller so no workers are started by default, no cpu at all starts no workers and the
+// placement report says so. Either pool must still run work on the calling thread. Returns non zero on failure.
+
+#include <stdlib.h>
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <PoolFuture.h>
+
+using namespace std;
+
+namespace
+{
+
+int s_numFailures = 0;
+
+void check(bool cond, const char* pMsg)
+{
+	if (!cond) {
+		cout << "FAILED: " << pMsg << "\n";
+		s_numFailures++;
+	}
+}
+
+bool runsWork(const MultiCore::ThreadPool& pool)
+{
+	atomic<size_t> numRun = 0;
+	pool.run(100, [&numRun](size_t, size_t)->bool {
+		numRun++;
+		return true;
+	}, true);
+	return numRun == 100 && pool.submit([]() { return 5; }).get() == 5;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const auto& cpus = MultiCore::CpuTopology::get().getCpus();
+
+	{
+		MultiCore::PlacementOptions placement;
+		placement._pinThreads = true;
+		for (size_t i = 1; i < cpus.size(); i++)
+			placement._reservedCpus.push_back(cpus[i]._cpu);
+
+		MultiCore::ThreadPool pool(0, 0, 0, placement);
+		check(pool.getNumAllocatedThreads() == 0, "no worker shares the caller's only cpu by default");
+		check(pool.getNumThreads() == 1, "one thread for one cpu");
+		check(runsWork(pool), "single cpu pool runs work");
+	}
+
+	{
+		MultiCore::PlacementOptions placement;
+		placement._pinThreads = true;
+		for (const auto& info : cpus)
+			placement._reservedCpus.push_back(info._cpu);
+
+		MultiCore::ThreadPool pool(0, 0, 4, placement);
+		check(pool.getNumAllocatedThreads() == 0, "no workers when every cpu is reserved");
+		check(pool.getWorkerPlacement().empty(), "no placement when every cpu is reserved");
+		check(pool.getPlacementReport().find("no cpus left") != string::npos, "report says no cpus are left");
+		check(runsWork(pool), "pool without cpus runs work on the caller");
+	}
+
+	cout << (s_numFailures == 0 ? "PASSED\n" : "FAILED\n");
+	return s_numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
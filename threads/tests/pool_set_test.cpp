@@ -0,0 +1,103 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// Deferred sort mode of MultiCore::set.
+// Checks that deferred inserts give the same contents as immediate ones, that they don't commit on every insert
+// (a deferred build of random keys must not be slower than the immediate build, which shifts the vector each insert)
+// and that inserts after a commit are staged again. Returns non zero on failure.
+
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+#include <pool_set.h>
+
+using namespace std;
+
+namespace
+{
+
+int s_numFailures = 0;
+
+void check(bool cond, const char* pMsg)
+{
+	if (!cond) {
+		cout << "FAILED: " << pMsg << "\n";
+		s_numFailures++;
+	}
+}
+
+template<class F>
+double seconds(F f)
+{
+	auto start = chrono::steady_clock::now();
+	f();
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const size_t numKeys = 50000;
+	mt19937 rng(1234);
+	vector<int> keys(numKeys);
+	for (auto& key : keys)
+		key = (int)(rng() % (numKeys * 2));
+	std::set<int> expected(keys.begin(), keys.end());
+
+	MultiCore::set<int> immediate, deferred;
+	deferred.setDeferredSort(true);
+
+	double immediateTime = seconds([&]() {
+		for (int key : keys)
+			immediate.insert(key);
+	});
+	double deferredTime = seconds([&]() {
+		for (int key : keys)
+			deferred.insert(key);
+	});
+
+	check(deferredTime < immediateTime, "deferred inserts commit on every insert");
+	check(deferred.size() == expected.size(), "deferred size");
+	check(equal(deferred.begin(), deferred.end(), expected.begin(), expected.end()), "deferred contents");
+	check(equal(immediate.begin(), immediate.end(), expected.begin(), expected.end()), "immediate contents");
+
+	// Staging again after a commit, including keys already present
+	deferred.insert(-1);
+	deferred.insert(keys[0]);
+	check(deferred.contains(-1), "insert after commit");
+	check(deferred.size() == expected.size() + 1, "duplicate merged after commit");
+	check(deferred.find(keys[0]) != deferred.end(), "find after commit");
+
+	cout << "immediate " << immediateTime << " s, deferred " << deferredTime << " s\n";
+	cout << (s_numFailures == 0 ? "PASSED\n" : "FAILED\n");
+	return s_numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
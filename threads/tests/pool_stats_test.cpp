@@ -0,0 +1,122 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// MultiCore::ThreadPool statistics around a function that throws.
+// The chunk that threw must still be charged to its run and worker, and runs after a failed nested run must be
+// counted as before. Returns non zero on failure.
+
+#include <stdlib.h>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <MultiCoreUtil.h>
+
+using namespace std;
+
+namespace
+{
+
+int s_numFailures = 0;
+
+void check(bool cond, const char* pMsg)
+{
+	if (!cond) {
+		cout << "FAILED: " << pMsg << "\n";
+		s_numFailures++;
+	}
+}
+
+const uint64_t s_spinNs = 20000000;
+
+void spin()
+{
+	auto start = chrono::steady_clock::now();
+	while ((uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count() < s_spinNs) {
+	}
+}
+
+void totals(const MultiCore::PoolStats& stats, uint64_t& busyNs, size_t& numChunks)
+{
+	busyNs = 0;
+	numChunks = 0;
+	for (const auto& worker : stats._workers) {
+		busyNs += worker._busyNs;
+		numChunks += worker._numChunks;
+	}
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	MultiCore::ThreadPool pool(4, 4, 4);
+	pool.enableStats(true);
+
+	try {
+		pool.run(1, [](size_t threadNum, size_t i)->bool {
+			spin();
+			throw runtime_error("chunk failed");
+		}, true);
+	} catch (const runtime_error&) {
+	}
+
+	auto stats = pool.getStats();
+	uint64_t busyNs;
+	size_t numChunks;
+	totals(stats, busyNs, numChunks);
+	check(stats._runs.size() == 1, "failed run is recorded");
+	check(!stats._runs.empty() && stats._runs.back()._busyNs >= s_spinNs, "failed chunk is charged to its run");
+	check(busyNs >= s_spinNs && numChunks == 1, "failed chunk is charged to its worker");
+
+	pool.resetStats();
+	try {
+		pool.run(1, [&pool](size_t threadNum, size_t i)->bool {
+			pool.runSub(1, 1, [](size_t threadNum, size_t j)->bool {
+				spin();
+				throw runtime_error("nested chunk failed");
+			}, true);
+			return true;
+		}, true);
+	} catch (const runtime_error&) {
+	}
+
+	// A nested chunk is inside the outer one, only the outer one counts for the worker
+	stats = pool.getStats();
+	totals(stats, busyNs, numChunks);
+	check(busyNs >= s_spinNs && numChunks == 1, "failed nested run is charged once");
+
+	pool.resetStats();
+	pool.run(4, [](size_t threadNum, size_t i)->bool {
+		return true;
+	}, true);
+	stats = pool.getStats();
+	totals(stats, busyNs, numChunks);
+	check(numChunks >= 1, "chunks are counted after a failed run");
+
+	cout << (s_numFailures == 0 ? "PASSED\n" : "FAILED\n");
+	return s_numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,106 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// Destroying a MultiCore::ThreadPool with queued tasks.
+// Every queued task must still run, including tasks queued by running tasks and continuations, so futures waiting on
+// them complete after the pool is gone. Returns non zero on failure.
+
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <PoolFuture.h>
+
+using namespace std;
+
+namespace
+{
+
+int s_numFailures = 0;
+
+void check(bool cond, const char* pMsg)
+{
+	if (!cond) {
+		cout << "FAILED: " << pMsg << "\n";
+		s_numFailures++;
+	}
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const int numTasks = 200;
+
+	{
+		atomic<int> numRan = 0;
+		vector<MultiCore::PoolFuture<int>> futures;
+		{
+			MultiCore::ThreadPool pool(2, 2, 2);
+			for (int i = 0; i < numTasks; i++) {
+				futures.push_back(pool.submit([&numRan, i]() {
+					this_thread::sleep_for(chrono::microseconds(100));
+					numRan++;
+					return i;
+				}));
+			}
+		}
+
+		check(numRan == numTasks, "queued tasks run before the pool is gone");
+		bool allReady = true, allValues = true;
+		for (int i = 0; i < numTasks; i++) {
+			allReady = allReady && futures[i].isReady();
+			allValues = allValues && futures[i].get() == i;
+		}
+		check(allReady, "futures are ready after the pool is gone");
+		check(allValues, "futures hold their task's value");
+	}
+
+	{
+		// Tasks and continuations queueing more work while the pool shuts down
+		atomic<int> numRan = 0;
+		MultiCore::PoolFuture<int> last;
+		{
+			MultiCore::ThreadPool pool(2, 2, 2);
+			for (int i = 0; i < numTasks; i++) {
+				pool.enqueue([&pool, &numRan]() {
+					pool.enqueue([&numRan]() {
+						numRan++;
+					});
+				});
+			}
+			last = pool.submit([]() { return 1; }).then([](int v) { return v + 1; });
+		}
+		check(numRan == numTasks, "tasks queued by tasks run before the pool is gone");
+		check(last.isReady() && last.get() == 2, "continuation runs before the pool is gone");
+	}
+
+	cout << (s_numFailures == 0 ? "PASSED\n" : "FAILED\n");
+	return s_numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
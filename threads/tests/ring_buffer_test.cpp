@@ -0,0 +1,94 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// MultiCore::spsc_ring_buffer between a producer and a consumer thread.
+// Entries must arrive in order, and a popped entry must not stay alive in its slot. Returns non zero on failure.
+
+#include <stdlib.h>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <ring_buffer.h>
+
+using namespace std;
+
+namespace
+{
+
+int s_numFailures = 0;
+
+void check(bool cond, const char* pMsg)
+{
+	if (!cond) {
+		cout << "FAILED: " << pMsg << "\n";
+		s_numFailures++;
+	}
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	{
+		MultiCore::spsc_ring_buffer<shared_ptr<int>> ring(4);
+		auto p = make_shared<int>(5);
+		check(ring.try_push(p), "push");
+		check(p.use_count() == 2, "pushed entry holds a reference");
+
+		shared_ptr<int> popped;
+		check(ring.try_pop(popped) && popped == p, "pop returns the entry");
+		check(p.use_count() == 2, "popped entry is released from its slot");
+		popped.reset();
+		check(p.use_count() == 1, "nothing else holds the popped entry");
+		check(ring.empty(), "empty after the pop");
+	}
+
+	{
+		const size_t numEntries = 100000;
+		MultiCore::spsc_ring_buffer<size_t> ring(64);
+		thread producer([&ring]() {
+			for (size_t i = 0; i < numEntries; i++) {
+				while (!ring.try_push(i))
+					this_thread::yield();
+			}
+		});
+
+		bool inOrder = true;
+		for (size_t expected = 0; expected < numEntries; expected++) {
+			size_t val;
+			while (!ring.try_pop(val))
+				this_thread::yield();
+			inOrder = inOrder && val == expected;
+		}
+		producer.join();
+		check(inOrder, "entries arrive in order");
+		check(ring.empty(), "empty once everything is popped");
+	}
+
+	cout << (s_numFailures == 0 ? "PASSED\n" : "FAILED\n");
+	return s_numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
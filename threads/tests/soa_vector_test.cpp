@@ -0,0 +1,120 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// MultiCore::soa_vector columns, rows and growth.
+// Each field must be its own SOA_ALIGNMENT aligned array, rows must read and write through to the columns, and
+// growing, copying, pop_back and iteration must keep the values. Returns non zero on failure.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <soa_vector.h>
+
+using namespace std;
+
+namespace
+{
+
+int s_numFailures = 0;
+
+void check(bool cond, const char* pMsg)
+{
+	if (!cond) {
+		cout << "FAILED: " << pMsg << "\n";
+		s_numFailures++;
+	}
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	using Points = MultiCore::soa_vector<float, double, int>;
+	const size_t numRows = 1000;
+
+	Points vec;
+	check(vec.empty(), "new vector is empty");
+	for (size_t i = 0; i < numRows; i++)
+		vec.push_back((float)i, i * 0.5, (int)i * 3);
+	check(vec.size() == numRows && vec.capacity() >= numRows, "push_back grows the vector");
+
+	check((uintptr_t)vec.data<0>() % SOA_ALIGNMENT == 0, "float column aligned");
+	check((uintptr_t)vec.data<1>() % SOA_ALIGNMENT == 0, "double column aligned");
+	check((uintptr_t)vec.data<2>() % SOA_ALIGNMENT == 0, "int column aligned");
+	check(vec.fieldBytes<1>() == numRows * sizeof(double), "fieldBytes covers the used rows");
+
+	bool columnsOk = true;
+	auto xs = vec.field<0>();
+	auto ys = vec.field<1>();
+	auto zs = vec.field<2>();
+	check(xs.size() == numRows && ys.size() == numRows && zs.size() == numRows, "field spans cover the used rows");
+	for (size_t i = 0; i < numRows; i++)
+		columnsOk = columnsOk && xs[i] == (float)i && ys[i] == i * 0.5 && zs[i] == (int)i * 3;
+	check(columnsOk, "columns keep their values across growth");
+
+	vec[10].get<2>() = -1;
+	vec[11] = Points::value_type(1.5f, 2.5, 7);
+	check(vec.get<2>(10) == -1, "row get writes through to the column");
+	check(vec.data<0>()[11] == 1.5f && vec.get<1>(11) == 2.5 && vec.get<2>(11) == 7, "row assignment sets every field");
+	check(Points::value_type(vec[11]) == Points::value_type(1.5f, 2.5, 7), "row converts to a tuple");
+
+	Points copy(vec);
+	vec.get<1>(0) = 99.0;
+	check(copy.size() == numRows && copy.get<1>(0) == 0.0, "copy is independent");
+
+	size_t numIterated = 0;
+	double sum = 0;
+	for (auto row : copy) {
+		sum += row.get<1>();
+		numIterated++;
+	}
+	double expected = 0;
+	for (size_t i = 0; i < numRows; i++)
+		expected += i * 0.5;
+	expected += 2.5 - 11 * 0.5;
+	check(numIterated == numRows && sum == expected, "iteration visits every row");
+
+	copy.pop_back();
+	check(copy.size() == numRows - 1, "pop_back shrinks");
+	copy.resize(10);
+	check(copy.size() == 10 && copy.get<0>(9) == 9.0f, "resize keeps the leading rows");
+	copy.clear();
+	check(copy.empty(), "clear empties");
+
+	MultiCore::soa_vector<string, int> strings;
+	for (int i = 0; i < 100; i++)
+		strings.push_back(to_string(i), i);
+	bool stringsOk = true;
+	for (int i = 0; i < 100; i++)
+		stringsOk = stringsOk && strings.get<0>(i) == to_string(i) && strings.get<1>(i) == i;
+	check(stringsOk, "non trivial fields survive growth");
+
+	cout << (s_numFailures == 0 ? "PASSED\n" : "FAILED\n");
+	return s_numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
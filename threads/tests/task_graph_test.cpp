@@ -0,0 +1,144 @@
+/*
+This file is part of the DistFieldHexMesh application/library.
+
+	The DistFieldHexMesh application/library is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	The DistFieldHexMesh application/library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This link provides the exact terms of the GPL license <https://www.gnu.org/licenses/>.
+
+	The author's interpretation of GPL 3 is that if you receive money for the use or distribution of the DistFieldHexMesh application/library or a derivative product, GPL 3 no longer applies.
+
+	Under those circumstances, the author expects and may legally pursue a reasoble share of the income. To avoid the complexity of agreements and negotiation, the author makes
+	no specific demands in this regard. Compensation of roughly 1% of net or $5 per user license seems appropriate, but is not legally binding.
+
+	In lay terms, if you make a profit by using the DistFieldHexMesh application/library (violating the spirit of Open Source Software), I expect a reasonable share for my efforts.
+
+	Robert R Tipton - Author
+
+	Dark Sky Innovative Solutions http://darkskyinnovation.com/
+*/
+
+// MultiCore::TaskGraph runs nodes in dependency order and reports a failing task.
+// wait() must rethrow the first exception and skip the nodes after the failure, the graph and pool must be usable
+// afterwards and destroying a running graph whose task threw must not terminate. Returns non zero on failure.
+
+#include <stdlib.h>
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <TaskGraph.h>
+
+using namespace std;
+
+namespace
+{
+
+int s_numFailures = 0;
+
+void check(bool cond, const char* pMsg)
+{
+	if (!cond) {
+		cout << "FAILED: " << pMsg << "\n";
+		s_numFailures++;
+	}
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	MultiCore::ThreadPool pool(4, 4, 4);
+
+	{
+		// Diamond, each node checks its predecessors have finished
+		MultiCore::TaskGraph graph(pool);
+		atomic<int> order[4] = { -1, -1, -1, -1 };
+		atomic<int> counter = 0;
+		auto a = graph.addNode([&]() { order[0] = counter++; });
+		auto b = graph.addNode([&]() { order[1] = counter++; }, { a });
+		auto c = graph.addNode([&]() { order[2] = counter++; }, { a });
+		auto d = graph.addNode([&]() { order[3] = counter++; }, { b, c });
+		graph.runAndWait();
+		check(counter == 4, "every node ran");
+		check(order[0] < order[1] && order[0] < order[2], "successors run after their predecessor");
+		check(order[3] > order[1] && order[3] > order[2], "join runs after both predecessors");
+		check(graph.isDone(d), "join is done");
+	}
+
+	{
+		// wait() releases nodes nobody called run() for
+		MultiCore::TaskGraph graph(pool);
+		atomic<int> numRan = 0;
+		auto a = graph.addNode([&numRan]() { numRan++; });
+		graph.addNode([&numRan]() { numRan++; }, { a });
+		graph.wait();
+		check(numRan == 2, "wait without run runs the graph");
+
+		graph.addNode([&numRan]() { numRan++; }, { a });
+		graph.wait();
+		check(numRan == 3, "wait runs nodes added after the last run");
+	}
+
+	{
+		MultiCore::TaskGraph graph(pool);
+		atomic<bool> successorRan = false;
+		auto a = graph.addNode([]() { throw runtime_error("node failed"); });
+		graph.addNode([&]() { successorRan = true; }, { a });
+
+		bool caught = false;
+		try {
+			graph.runAndWait();
+		} catch (const runtime_error&) {
+			caught = true;
+		}
+		check(caught, "wait rethrows the task's exception");
+		check(!successorRan, "successor of a failed node is skipped");
+
+		// The failure is consumed, the graph runs again
+		atomic<bool> laterRan = false;
+		graph.addNode([&]() { laterRan = true; });
+		bool threw = false;
+		try {
+			graph.runAndWait();
+		} catch (...) {
+			threw = true;
+		}
+		check(!threw, "wait after a rethrown failure doesn't rethrow again");
+		check(laterRan, "graph runs after a failure");
+	}
+
+	{
+		atomic<int> numRan = 0;
+		try {
+			MultiCore::TaskGraph graph(pool);
+			auto a = graph.addNode([&]() { numRan++; throw runtime_error("not waited for"); });
+			for (int i = 0; i < 16; i++)
+				graph.addNode([&]() { numRan++; }, { a });
+			graph.run();
+			// No wait(), the destructor waits and must not throw
+		} catch (...) {
+			check(false, "destructor doesn't throw");
+		}
+		check(numRan == 1, "destructor waits for the graph and skips the nodes after the failure");
+	}
+
+	{
+		atomic<int> counter = 0;
+		pool.run(64, [&counter](size_t threadNum, size_t i)->bool {
+			counter++;
+			return true;
+		}, true);
+		check(counter == 64, "pool runs after graph failures");
+	}
+
+	cout << (s_numFailures == 0 ? "PASSED\n" : "FAILED\n");
+	return s_numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}